@@ -0,0 +1,41 @@
+/**
+ * @file   barrier.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 23:21:44 2026
+ *
+ * @brief  A reusable barrier for a fixed number of threads.
+ *
+ */
+
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <condition_variable>
+#include <mutex>
+
+class Barrier {
+ public:
+    /// Initialize for n threads.
+    Barrier(unsigned int n): n(n), waiting(0), generation(0) {}
+
+    /// Wait until all n threads have arrived.
+    void wait() {
+        std::unique_lock<std::mutex> lock(m);
+        unsigned long g = generation;
+        if (++waiting == n) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+        }
+        else cv.wait(lock, [this, g] { return generation != g; });
+    }
+
+ private:
+    unsigned int n;
+    unsigned int waiting;
+    unsigned long generation;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+#endif
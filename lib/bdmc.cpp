@@ -0,0 +1,131 @@
+#include "bdmc.h"
+
+#include <cmath>
+
+void BDChain::init(size_t ns) {
+    if (ns < 2) out_error("A birth-death chain needs at least two states.");
+    this->ns = ns;
+    time_now = 0;
+    state_now = 0;
+    up = new_zeroes<double>(ns);
+    down = new_zeroes<double>(ns);
+    invariant_distribution = new_zeroes<double>(ns);
+    rg = new RanGen();
+}
+
+BDChain::BDChain(const double * up, const double * down, size_t ns) {
+    init(ns);
+    for (size_t i = 0; i < ns; i++) {
+        this->up[i] = up[i];
+        this->down[i] = down[i];
+    }
+    if (this->up[ns-1] != 0 || this->down[0] != 0)
+        out_error("Birth-death chain leaves the state space.");
+}
+
+BDChain::BDChain(gsl_matrix * q) {
+    if (!is_birth_death(q))
+        out_error("Transition rate matrix is not tridiagonal.");
+    init(q->size1);
+    for (size_t i = 0; i < ns; i++) {
+        if (i+1 < ns) up[i] = gsl_matrix_get(q, i, i+1);
+        if (i > 0) down[i] = gsl_matrix_get(q, i, i-1);
+    }
+}
+
+BDChain::~BDChain() {
+    delete rg;
+    delete[] up;
+    delete[] down;
+    delete[] invariant_distribution;
+}
+
+bool BDChain::is_birth_death(gsl_matrix * q) {
+    size_t s = q->size1;
+    if (s != q->size2) return false;
+    for (size_t i = 0; i < s; i++) {
+        for (size_t j = 0; j < s; j++) {
+            if ((j+1 < i || j > i+1) && gsl_matrix_get(q, i, j) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+void BDChain::set_rates(state i, double up_i, double down_i) {
+    if (i >= ns) out_error("State out of range.");
+    if ((i == ns-1 && up_i != 0) || (i == 0 && down_i != 0))
+        out_error("Birth-death chain leaves the state space.");
+    up[i] = up_i;
+    down[i] = down_i;
+}
+
+void BDChain::stationary_distribution(double * pi) {
+    // Detailed balance on the log scale.
+    pi[0] = 0;
+    double max = 0;
+    for (size_t i = 0; i+1 < ns; i++) {
+        pi[i+1] = pi[i] + std::log(up[i]) - std::log(down[i+1]);
+        if (pi[i+1] > max) max = pi[i+1];
+    }
+    double sum = 0;
+    for (size_t i = 0; i < ns; i++) {
+        pi[i] = std::exp(pi[i] - max);
+        sum += pi[i];
+    }
+    for (size_t i = 0; i < ns; i++) pi[i] /= sum;
+}
+
+void BDChain::set_state_stationary() {
+    double * pi = new double[ns];
+    stationary_distribution(pi);
+    double u = rg->pick_uniform();
+    double x = 0;
+    state_now = ns-1;
+    for (size_t i = 0; i < ns; i++) {
+        x += pi[i];
+        if (u < x) {
+            state_now = i;
+            break;
+        }
+    }
+    delete[] pi;
+}
+
+state BDChain::run(double dt) {
+    double t_end = time_now + dt;
+    for (;;) {
+        double rate = up[state_now] + down[state_now];
+        double holding_time = rg->pick_exponential(1.0/rate);
+        if (time_now + holding_time >= t_end) {
+            invariant_distribution[state_now] += t_end - time_now;
+            time_now = t_end;
+            break;
+        }
+        invariant_distribution[state_now] += holding_time;
+        time_now += holding_time;
+        if (rg->pick_uniform() * rate < up[state_now]) state_now++;
+        else state_now--;
+    }
+    return state_now;
+}
+
+void BDChain::reset_analysis() {
+    time_now = 0;
+    for (size_t i = 0; i < ns; i++) invariant_distribution[i] = 0;
+}
+
+void BDChain::print_invariant_distribution(std::ostream & out) {
+    out << "The invariant distribution is:" << std::endl;
+    out << std::setiosflags(std::ios::fixed);
+    out << std::setprecision(8);
+    for (size_t i = 0; i < ns; i++) {
+        out << std::setw(10) << get_entry_invariant_distribution(i)
+            << std::endl;
+    }
+}
+
+double BDChain::get_entry_invariant_distribution(unsigned int i) {
+    if (time_now == 0) return 0;
+    return invariant_distribution[i] / time_now;
+}
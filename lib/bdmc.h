@@ -0,0 +1,126 @@
+/**
+ * @file   bdmc.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 11:02:51 2026
+ *
+ * @brief  A class to run a continuous-time birth-death Markov chain.
+ *
+ * The states are 0, ..., ns-1 and the chain only jumps from state i
+ * to i+1 (rate up_i) or i-1 (rate down_i).  Only the two rate
+ * vectors are stored, so that memory and time per jump do not depend
+ * on the number of states.  The stationary distribution is known in
+ * closed form by detailed balance,
+ * \f[
+ *  \pi_{i+1} = \pi_i \frac{up_i}{down_{i+1}},
+ * \f]
+ * and is computed in O(ns).
+ *
+ */
+
+#ifndef BDMC_H
+#define BDMC_H
+
+#include <iostream>
+#include <gsl/gsl_matrix.h>
+#include "ran_generator.h"
+#include "tools.h"
+
+typedef unsigned int state;
+
+class BDChain {
+ public:
+    /**
+     * Initialize the chain with given rates.
+     *
+     * @param up the rates to jump from i to i+1; up[ns-1] must be 0.
+     * @param down the rates to jump from i to i-1; down[0] must be 0.
+     * @param ns the number of states.
+     */
+    BDChain(const double * up, const double * down, size_t ns);
+
+    /**
+     * Initialize the chain from a tridiagonal transition rate matrix.
+     *
+     * @param q the transition rate matrix Q.
+     */
+    BDChain(gsl_matrix * q);
+
+    ~BDChain();
+
+    /**
+     * Check if a transition rate matrix is tridiagonal, i.e., if it
+     * describes a birth-death chain.
+     *
+     * @param q the transition rate matrix Q.
+     *
+     * @return true if Q is tridiagonal.
+     */
+    static bool is_birth_death(gsl_matrix * q);
+
+    /**
+     * Change the rates of a single state.
+     *
+     * @param i the state.
+     * @param up_i the rate to jump from i to i+1.
+     * @param down_i the rate to jump from i to i-1.
+     */
+    void set_rates(state i, double up_i, double down_i);
+
+    /**
+     * Compute the stationary distribution by detailed balance.  The
+     * recursion is done on the log scale so that it does not
+     * overflow for large chains.  The chain has to be irreducible.
+     *
+     * @param pi OUT; array of length ns.
+     */
+    void stationary_distribution(double * pi);
+
+    /**
+     * Set the state of the chain to a draw from its stationary
+     * distribution.  No burn in is needed afterwards.
+     *
+     */
+    void set_state_stationary();
+
+    /**
+     * Let the chain run for the given time.  The direction of each
+     * jump is chosen with a single uniform random variable.
+     *
+     * @param dt the time to run.
+     *
+     * @return the state the chain ends up in.
+     */
+    state run(double dt);
+
+    /**
+     * Reset time and invariant distribution but keep the current
+     * state of the chain.
+     *
+     */
+    void reset_analysis();
+
+    void print_invariant_distribution(std::ostream & out);
+
+    double get_entry_invariant_distribution(unsigned int i);
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    /// Allocate and zero the rate and analysis arrays.
+    void init(size_t ns);
+    /// Time of the Markov chain.
+    double time_now;
+    /// Current state of the chain.
+    state state_now;
+    /// Number of states.
+    size_t ns;
+    /// Rates to jump up.
+    double * up;
+    /// Rates to jump down.
+    double * down;
+    /// Time spent in each state.
+    double * invariant_distribution;
+};
+
+#endif
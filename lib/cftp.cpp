@@ -0,0 +1,130 @@
+#include "cftp.h"
+#include "tools.h"
+
+#include <thread>
+
+BirthDeathUpdate::BirthDeathUpdate(const double * up, const double * down,
+                                   size_t ns):
+    p_up(ns),
+    p_down(ns)
+{
+    this->ns = ns;
+    if (ns < 2) out_error("A birth-death chain needs at least two states.");
+    if (up[ns-1] != 0 || down[0] != 0)
+        out_error("Birth-death chain leaves the state space.");
+    double l = 0;
+    for (size_t i = 0; i < ns; i++) {
+        if (up[i] < 0 || down[i] < 0) out_error("Negative rate.");
+        if (up[i] + down[i] > l) l = up[i] + down[i];
+        if (i + 1 < ns && up[i] + down[i+1] > l) l = up[i] + down[i+1];
+    }
+    if (l <= 0) out_error("Birth-death chain without transitions.");
+    for (size_t i = 0; i < ns; i++) {
+        p_up[i] = up[i] / l;
+        p_down[i] = down[i] / l;
+    }
+}
+
+InverseCdfUpdate::InverseCdfUpdate(const gsl_matrix * p):
+    cdf(p->size1 * p->size2)
+{
+    ns = p->size1;
+    if (p->size2 != ns || ns == 0)
+        out_error("The transition probability matrix has to be square.");
+    for (size_t i = 0; i < ns; i++) {
+        double sum = 0;
+        for (size_t j = 0; j < ns; j++) {
+            if (gsl_matrix_get(p, i, j) < 0)
+                out_error("Negative transition probability.");
+            sum += gsl_matrix_get(p, i, j);
+        }
+        if (sum <= 0) out_error("Row without transitions.");
+        double c = 0;
+        for (size_t j = 0; j < ns; j++) {
+            c += gsl_matrix_get(p, i, j) / sum;
+            cdf[i*ns + j] = c;
+        }
+        cdf[i*ns + ns - 1] = 1;
+    }
+    // A row has to put less mass below each state than the row above.
+    for (size_t i = 0; i + 1 < ns; i++)
+        for (size_t j = 0; j < ns; j++)
+            if (cdf[(i+1)*ns + j] > cdf[i*ns + j] + 1e-12)
+                out_error("The rows are not stochastically increasing.");
+}
+
+state InverseCdfUpdate::update(state x, double u) const {
+    // Binary search for the first state with cdf > u.
+    const double * c = &cdf[x * ns];
+    size_t lo = 0, hi = ns - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (c[mid] > u) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+state cftp_sample(const MonotoneUpdate & f, RanGen & rg,
+                  unsigned long * t_back) {
+    // u[k] moves the chains from time -(k+1) to -k.
+    std::vector<double> u;
+    unsigned long t = 1;
+    state top = f.get_n_states() - 1;
+    while (true) {
+        if (t > CFTP_MAX_T)
+            out_error("The chains did not meet; is the chain irreducible?");
+        while (u.size() < t) u.push_back(rg.pick_uniform());
+        state lo = 0;
+        state hi = top;
+        for (unsigned long k = t; k > 0; k--) {
+            lo = f.update(lo, u[k-1]);
+            hi = f.update(hi, u[k-1]);
+        }
+        if (lo == hi) {
+            if (t_back) *t_back = t;
+            return lo;
+        }
+        t *= 2;
+    }
+}
+
+/**
+ * Draw a share of the states in one thread.
+ */
+void cftp_samples_thread(const MonotoneUpdate * f, RanGen * rg,
+                         state * samples, unsigned long * t_back,
+                         unsigned long n) {
+    for (unsigned long k = 0; k < n; k++)
+        samples[k] = cftp_sample(*f, *rg, &t_back[k]);
+}
+
+void cftp_samples(const MonotoneUpdate & f, unsigned long n_samples,
+                  unsigned int n_threads, unsigned long seed,
+                  std::vector<state> & samples,
+                  std::vector<unsigned long> & t_back) {
+    if (n_threads == 0) n_threads = 1;
+    samples.assign(n_samples, 0);
+    t_back.assign(n_samples, 0);
+    if (n_samples == 0) return;
+    // The constructor of RanGen sets global GSL defaults; initialize
+    // the generators before the threads start.
+    std::vector<RanGen*> rg;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        rg.push_back(new RanGen());
+        rg[t]->set_seed(seed + t);
+    }
+    std::vector<std::thread> threads;
+    unsigned long start = 0;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        unsigned long share = n_samples / n_threads;
+        if (t < n_samples % n_threads) share++;
+        threads.push_back(std::thread(cftp_samples_thread, &f, rg[t],
+                                      samples.data() + start,
+                                      t_back.data() + start,
+                                      share));
+        start += share;
+    }
+    for (unsigned int t = 0; t < n_threads; t++) threads[t].join();
+    for (unsigned int t = 0; t < n_threads; t++) delete rg[t];
+}
@@ -0,0 +1,138 @@
+/**
+ * @file   cftp.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 23:58:19 2026
+ *
+ * @brief  Exact draws from the stationary distribution of monotone
+ * chains by coupling from the past (Propp and Wilson, 1996).
+ *
+ * A chain on the states 0, ..., ns-1 is given by an update function
+ * x' = f(x, u) with u uniform on [0,1).  It is monotone if x <= y
+ * implies f(x, u) <= f(y, u) for all u.  Then, the chains started in
+ * the bottom state 0 and in the top state ns-1 at time -T sandwich
+ * the chains from all other states.  If they have met at time 0, all
+ * chains have, and the common state is an exact draw from the
+ * stationary distribution.  Otherwise, T is doubled and the run is
+ * repeated, reusing the uniforms of the times that have been
+ * visited before; reusing them is essential for exactness.
+ *
+ * Update functions:
+ * - BirthDeathUpdate: a continuous-time birth-death chain (see
+ *   bdmc.h), made discrete by uniformization with the rate L =
+ *   max_i(up_i + down_{i+1}): up if u < up_i/L, down if u >= 1 -
+ *   down_i/L, stay otherwise.  The choice of L prevents neighboring
+ *   states from crossing, so that the update is monotone; the
+ *   stationary distribution is the one of the continuous chain.
+ *   This covers the Moran model with boundary mutation and the
+ *   Ehrenfest chain (made lazy, which also removes its period).
+ * - InverseCdfUpdate: a discrete-time chain with a transition
+ *   probability matrix whose rows are stochastically increasing; the
+ *   next state is the inverse of the cumulative distribution of the
+ *   row at u.  This covers the Wright-Fisher model with boundary
+ *   mutation if the scaled mutation rate is at most one.
+ *
+ */
+
+#ifndef CFTP_H
+#define CFTP_H
+
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include "ran_generator.h"
+
+typedef unsigned int state;
+
+/// Maximum number of steps back in time before cftp_sample() gives
+/// up; the uniforms of all steps are stored (8 bytes each).
+const unsigned long CFTP_MAX_T = 1ul << 26;
+
+/**
+ * A monotone update function on the states 0, ..., ns-1.
+ *
+ */
+class MonotoneUpdate {
+ public:
+    virtual ~MonotoneUpdate() {}
+
+    /// The next state of x with the uniform u.
+    virtual state update(state x, double u) const = 0;
+
+    /// The number of states.
+    size_t get_n_states() const { return ns; }
+
+ protected:
+    size_t ns;
+};
+
+class BirthDeathUpdate : public MonotoneUpdate {
+ public:
+    /**
+     * Initialize with the rates of a birth-death chain.
+     *
+     * @param up the rates to jump from i to i+1; up[ns-1] must be 0.
+     * @param down the rates to jump from i to i-1; down[0] must be 0.
+     * @param ns the number of states.
+     */
+    BirthDeathUpdate(const double * up, const double * down, size_t ns);
+
+    state update(state x, double u) const {
+        if (u < p_up[x]) return x + 1;
+        if (u >= 1 - p_down[x]) return x - 1;
+        return x;
+    }
+
+ private:
+    /// Probabilities to go up and down in one step.
+    std::vector<double> p_up;
+    std::vector<double> p_down;
+};
+
+class InverseCdfUpdate : public MonotoneUpdate {
+ public:
+    /**
+     * Initialize with a transition probability matrix; it is checked
+     * that the rows are stochastically increasing.
+     *
+     * @param p the transition probability matrix P; the rows need
+     * not be normalized.
+     */
+    InverseCdfUpdate(const gsl_matrix * p);
+
+    state update(state x, double u) const;
+
+ private:
+    /// Cumulative distributions of the rows, row by row.
+    std::vector<double> cdf;
+};
+
+/**
+ * Draw one state from the stationary distribution.
+ *
+ * @param f the update function.
+ * @param rg random number generator.
+ * @param t_back OUT; if not NULL, the number of steps back in time
+ * that were needed.  The program exits with an error if the chains
+ * have not met after CFTP_MAX_T steps.
+ *
+ * @return the state.
+ */
+state cftp_sample(const MonotoneUpdate & f, RanGen & rg,
+                  unsigned long * t_back=NULL);
+
+/**
+ * Draw independent states from the stationary distribution on several
+ * threads.
+ *
+ * @param f the update function.
+ * @param n_samples the number of draws.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param samples OUT; the draws.
+ * @param t_back OUT; the steps back in time of each draw.
+ */
+void cftp_samples(const MonotoneUpdate & f, unsigned long n_samples,
+                  unsigned int n_threads, unsigned long seed,
+                  std::vector<state> & samples,
+                  std::vector<unsigned long> & t_back);
+
+#endif
@@ -0,0 +1,165 @@
+#include "coalescent.h"
+#include "tools.h"
+
+#include <thread>
+
+unsigned int Coalescent::check_sample_size(unsigned int n) {
+    if (n < 2) out_error("The sample size has to be at least two.");
+    return n;
+}
+
+Coalescent::Coalescent(unsigned int n):
+    n(check_sample_size(n)),
+    nodes(2*n-1),
+    lineages(n)
+{
+}
+
+void Coalescent::simulate(RanGen & rg) {
+    unsigned int i;
+    for (i = 0; i < n; i++) {
+        nodes[i].time = 0;
+        nodes[i].n_leaves = 1;
+        nodes[i].parent = -1;
+        lineages[i] = i;
+    }
+    double t = 0;
+    unsigned int next = n;
+    for (unsigned int k = n; k > 1; k--) {
+        t += rg.pick_exponential(2.0 / ((double) k * (k-1)));
+        // Remove two random lineages; the removed ones are swapped to
+        // the end of the active range.
+        unsigned int a = rg.pick_uniform_int(k);
+        unsigned int la = lineages[a];
+        lineages[a] = lineages[k-1];
+        unsigned int b = rg.pick_uniform_int(k-1);
+        unsigned int lb = lineages[b];
+        coal_node & p = nodes[next];
+        p.time = t;
+        p.n_leaves = nodes[la].n_leaves + nodes[lb].n_leaves;
+        p.parent = -1;
+        nodes[la].parent = next;
+        nodes[lb].parent = next;
+        lineages[b] = next;
+        next++;
+    }
+}
+
+unsigned long Coalescent::mutate(double theta, RanGen & rg,
+                                 std::vector<unsigned long> & sfs) {
+    unsigned long n_seg = 0;
+    for (unsigned int i = 0; i < 2*n-2; i++) {
+        double length = nodes[nodes[i].parent].time - nodes[i].time;
+        unsigned int m = rg.pick_poisson(theta / 2.0 * length);
+        sfs[nodes[i].n_leaves] += m;
+        n_seg += m;
+    }
+    return n_seg;
+}
+
+double Coalescent::get_total_length() const {
+    double length = 0;
+    for (unsigned int i = 0; i < 2*n-2; i++)
+        length += nodes[nodes[i].parent].time - nodes[i].time;
+    return length;
+}
+
+double Coalescent::get_mean_pairwise_time() const {
+    // A branch above i leaves separates i(n-i) pairs of leaves.
+    double sum = 0;
+    for (unsigned int i = 0; i < 2*n-2; i++) {
+        double length = nodes[nodes[i].parent].time - nodes[i].time;
+        double l = nodes[i].n_leaves;
+        sum += length * l * (n - l);
+    }
+    // The pairwise distance is twice the coalescence time.
+    return sum / ((double) n * (n-1));
+}
+
+CoalescentStats::CoalescentStats(unsigned int n):
+    n(n),
+    n_reps(0),
+    sum_tmrca(0),
+    sum_length(0),
+    sum_pairwise_time(0),
+    sum_seg_sites(0),
+    sfs(n+1, 0)
+{
+}
+
+void CoalescentStats::merge(const CoalescentStats & o) {
+    if (o.n != n) out_error("Sample sizes do not match.");
+    n_reps += o.n_reps;
+    sum_tmrca += o.sum_tmrca;
+    sum_length += o.sum_length;
+    sum_pairwise_time += o.sum_pairwise_time;
+    sum_seg_sites += o.sum_seg_sites;
+    for (unsigned int i = 0; i <= n; i++) sfs[i] += o.sfs[i];
+}
+
+void CoalescentStats::print(std::ostream & out) const {
+    out << "Number of genealogies: " << n_reps << std::endl;
+    out << "Mean time to the most recent common ancestor: "
+        << sum_tmrca / n_reps << std::endl;
+    out << "Mean total branch length: "
+        << sum_length / n_reps << std::endl;
+    out << "Mean pairwise coalescence time: "
+        << sum_pairwise_time / n_reps << std::endl;
+    out << "Mean number of segregating sites: "
+        << (double) sum_seg_sites / n_reps << std::endl;
+    if (sum_seg_sites == 0) return;
+    out << "Site frequency spectrum:" << std::endl;
+    for (unsigned int i = 1; i < n; i++) {
+        out << std::setw(8) << i;
+        out << std::setw(12) << (double) sfs[i] / sum_seg_sites;
+        out << std::endl;
+    }
+}
+
+/**
+ * Simulate a share of the genealogies in one thread.  Each thread
+ * has its own node pool.
+ */
+void coalescent_replicates_thread(unsigned int n, double theta,
+                                  unsigned long n_reps, RanGen * rgp,
+                                  CoalescentStats * stats) {
+    RanGen & rg = *rgp;
+    Coalescent c(n);
+    for (unsigned long r = 0; r < n_reps; r++) {
+        c.simulate(rg);
+        stats->n_reps++;
+        stats->sum_tmrca += c.get_tmrca();
+        stats->sum_length += c.get_total_length();
+        stats->sum_pairwise_time += c.get_mean_pairwise_time();
+        if (theta > 0)
+            stats->sum_seg_sites += c.mutate(theta, rg, stats->sfs);
+    }
+}
+
+void coalescent_replicates(unsigned int n, double theta,
+                           unsigned long n_reps, unsigned int n_threads,
+                           unsigned long seed, CoalescentStats & stats) {
+    if (n_threads == 0) n_threads = 1;
+    std::vector<CoalescentStats> thread_stats(n_threads,
+                                              CoalescentStats(n));
+    // The constructor of RanGen sets global GSL defaults; initialize
+    // the generators before the threads start.
+    std::vector<RanGen*> rg;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        rg.push_back(new RanGen());
+        rg[t]->set_seed(seed + t);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        unsigned long share = n_reps / n_threads;
+        if (t < n_reps % n_threads) share++;
+        threads.push_back(std::thread(coalescent_replicates_thread, n,
+                                      theta, share, rg[t],
+                                      &thread_stats[t]));
+    }
+    for (unsigned int t = 0; t < n_threads; t++) {
+        threads[t].join();
+        stats.merge(thread_stats[t]);
+        delete rg[t];
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file   coalescent.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 14:55:09 2026
+ *
+ * @brief  Simulate genealogies with the Kingman coalescent.
+ *
+ * A sample of n lineages is traced backward in time.  While there are
+ * k lineages, the time to the next coalescence is exponential with
+ * rate k(k-1)/2 (time in units of N generations of a haploid
+ * Wright-Fisher population) and two random lineages merge.  A
+ * genealogy takes n-1 events.  Mutations fall on the branches as a
+ * Poisson process with rate theta/2 per unit branch length; a
+ * mutation on a branch above i leaves is a site with i derived
+ * copies.
+ *
+ * The nodes of a genealogy are taken from a pool that is allocated
+ * once and reused for all genealogies.
+ *
+ */
+
+#ifndef COALESCENT_H
+#define COALESCENT_H
+
+#include <iostream>
+#include <vector>
+#include "ran_generator.h"
+
+/// A node of a genealogy; the leaves are the nodes 0, ..., n-1.
+struct coal_node {
+    /// Time of the node.
+    double time;
+    /// Number of leaves below the node.
+    unsigned int n_leaves;
+    /// Parent node; -1 for the root.
+    int parent;
+};
+
+class Coalescent {
+ public:
+    /**
+     * Initialize the node pool.
+     *
+     * @param n the sample size.
+     */
+    Coalescent(unsigned int n);
+
+    /**
+     * Simulate a new genealogy.
+     *
+     * @param rg random number generator.
+     */
+    void simulate(RanGen & rg);
+
+    /**
+     * Put mutations on the branches of the current genealogy.
+     *
+     * @param theta the scaled mutation rate.
+     * @param rg random number generator.
+     * @param sfs IN/OUT; entry i is increased by the number of sites
+     * with i derived copies; length n+1.
+     *
+     * @return the number of segregating sites.
+     */
+    unsigned long mutate(double theta, RanGen & rg,
+                         std::vector<unsigned long> & sfs);
+
+    /// The time to the most recent common ancestor.
+    double get_tmrca() const { return nodes[2*n-2].time; }
+
+    /// The total branch length.
+    double get_total_length() const;
+
+    /**
+     * The mean time to the most recent common ancestor of two
+     * distinct leaves; theta times this value is the expected
+     * heterozygosity.
+     *
+     */
+    double get_mean_pairwise_time() const;
+
+    /// The node pool; valid after simulate().
+    const std::vector<coal_node> & get_nodes() const { return nodes; }
+
+ private:
+    /// Check the sample size before the node pool is sized with it.
+    static unsigned int check_sample_size(unsigned int n);
+
+    /// Sample size.
+    unsigned int n;
+    /// Node pool of size 2n-1.
+    std::vector<coal_node> nodes;
+    /// Lineages that have not coalesced yet.
+    std::vector<unsigned int> lineages;
+};
+
+/**
+ * Summary statistics over many genealogies.
+ *
+ */
+struct CoalescentStats {
+    CoalescentStats(unsigned int n=2);
+    /// Add the statistics of another set of genealogies.
+    void merge(const CoalescentStats & o);
+    /// Print means and the normalized site frequency spectrum.
+    void print(std::ostream & out) const;
+    /// Sample size.
+    unsigned int n;
+    /// Number of genealogies.
+    unsigned long n_reps;
+    /// Sums over the genealogies.
+    double sum_tmrca;
+    double sum_length;
+    double sum_pairwise_time;
+    unsigned long sum_seg_sites;
+    /// Sum of site counts by number of derived copies.
+    std::vector<unsigned long> sfs;
+};
+
+/**
+ * Simulate independent genealogies on several threads.
+ *
+ * @param n the sample size.
+ * @param theta the scaled mutation rate; 0 for no mutations.
+ * @param n_reps the number of genealogies.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param stats IN/OUT; the genealogies are added.
+ */
+void coalescent_replicates(unsigned int n, double theta,
+                           unsigned long n_reps, unsigned int n_threads,
+                           unsigned long seed, CoalescentStats & stats);
+
+#endif
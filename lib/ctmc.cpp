@@ -1,33 +1,39 @@
 #include "ctmc.h"
 
+void set_q_no_diagonal_row(gsl_matrix * q, gsl_matrix * q_no_diagonal,
+                           size_t ns, size_t i) {
+    size_t j;
+    int above_diagonal = 0;
+    for (j = 0; j < ns-1; j++) {
+        if (i == j) above_diagonal = 1;
+        gsl_matrix_set(q_no_diagonal,
+                       i, j,
+                       gsl_matrix_get(q,i,j+above_diagonal));
+    }
+}
+
 void set_q_no_diagonal(gsl_matrix * q, gsl_matrix * q_no_diagonal,
                   size_t ns) {
-    size_t i, j;
-    int above_diagonal;
-    for (i = 0; i < ns; i++) {
-        above_diagonal = 0;
-        for (j = 0; j < ns-1; j++) {
-            if (i == j) above_diagonal = 1;
-            gsl_matrix_set(q_no_diagonal,
-                           i, j,
-                           gsl_matrix_get(q,i,j+above_diagonal));
-        }
-    }
+    size_t i;
+    for (i = 0; i < ns; i++)
+        set_q_no_diagonal_row(q, q_no_diagonal, ns, i);
 }
 
 CTMC::CTMC(gsl_matrix * q, size_t ns,
-           bool log_path):
+           bool log_path, unsigned int log_level):
     q(q),
     ns(ns),
     log_out(std::cout),
     log_path(log_path)
 {
-    std::cout << "Initializing CTMC." << std::endl;
-    std::cout << "Number of states: " << ns << std::endl;
-    unsigned int ram = 2 * ns * ns * sizeof(double);
-    double ram_mb = (double) ram / 1024 / 1024;
-    std::cout << std::setprecision(1);
-    std::cout << "RAM needed: " << ram_mb << " MB."<< std::endl;
+    if (log_level > 0) {
+        std::cout << "Initializing CTMC." << std::endl;
+        std::cout << "Number of states: " << ns << std::endl;
+        unsigned int ram = 2 * ns * ns * sizeof(double);
+        double ram_mb = (double) ram / 1024 / 1024;
+        std::cout << std::setprecision(1);
+        std::cout << "RAM needed: " << ram_mb << " MB."<< std::endl;
+    }
     // General CTMC variables and parameters.
     time_now = 0;
     time_previous = 0;
@@ -35,6 +41,9 @@ CTMC::CTMC(gsl_matrix * q, size_t ns,
     state_previous = 0;
     q_no_diagonal = gsl_matrix_alloc (ns, ns-1);
     set_q_no_diagonal(q, q_no_diagonal, ns);
+    exit_rates = new double[ns];
+    for (size_t i = 0; i < ns; i++)
+        exit_rates[i] = -gsl_matrix_get(q, i, i);
 
     // Auxiliary variables.
     rg = new RanGen();
@@ -63,7 +72,7 @@ CTMC::CTMC(gsl_matrix * q, size_t ns,
     // gsl_matrix_set_zero(jumps_direct_i);
 
     // Logs.
-    set_log_level();
+    set_log_level(log_level);
 
     // Burn chain in.  This should be done manually.
     // burn_it_in();
@@ -72,6 +81,7 @@ CTMC::CTMC(gsl_matrix * q, size_t ns,
 CTMC::~CTMC() {
     delete rg;
     gsl_matrix_free(q_no_diagonal);
+    delete[] exit_rates;
     delete[] invariant_distribution;
     // gsl_matrix_free(direct_hitting_times);
     // gsl_matrix_free(times_direct_i);
@@ -90,7 +100,7 @@ CTMC::~CTMC() {
 
 void CTMC::jump_maybe(double dt_max) {
     double holding_time =
-        rg->pick_exponential(-1.0/gsl_matrix_get(q,state_now,state_now));
+        rg->pick_exponential(1.0/exit_rates[state_now]);
     if (holding_time <= dt_max) {
         time_previous = time_now;
         time_now += holding_time;
@@ -145,6 +155,49 @@ void CTMC::burn_it_in() {
     }
 }
 
+void CTMC::update_rows(const std::vector<state> & rows) {
+    std::vector<state>::const_iterator it;
+    for (it = rows.begin(); it != rows.end(); it++) {
+        if (*it >= ns) out_error("Row index out of range.");
+        set_q_no_diagonal_row(q, q_no_diagonal, ns, *it);
+        exit_rates[*it] = -gsl_matrix_get(q, *it, *it);
+    }
+}
+
+void CTMC::reset_analysis() {
+    time_now = 0;
+    time_previous = 0;
+    jump_counter = 0;
+    for (size_t i = 0; i < ns; i++) invariant_distribution[i] = 0;
+}
+
+void CTMC::reset(state s) {
+    if (s >= ns) out_error("State out of range.");
+    state_now = s;
+    state_previous = s;
+    reset_analysis();
+}
+
+void CTMC::run_grid(const std::vector<double> & times,
+                    std::vector<state> & states) {
+    states.resize(times.size());
+    if (times.empty()) return;
+    if (times[0] < time_now) out_error("Grid time before current time.");
+    double t_next = time_now + rg->pick_exponential(1.0/exit_rates[state_now]);
+    for (size_t k = 0; k < times.size(); k++) {
+        if (k > 0 && times[k] < times[k-1])
+            out_error("Grid times have to be ascending.");
+        while (t_next <= times[k]) {
+            time_now = t_next;
+            jump_silently();
+            t_next = time_now
+                + rg->pick_exponential(1.0/exit_rates[state_now]);
+        }
+        states[k] = state_now;
+    }
+    time_now = times.back();
+}
+
 state CTMC::run(double dt) {
     double t_end = time_now + dt;
     while (time_now < t_end)
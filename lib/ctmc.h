@@ -29,9 +29,11 @@ class CTMC {
      *  @param q the transition rate matrix Q.
      *  @param ns the number of states.
      *  @param log_path set to true to log the full path.
+     *  @param log_level the log level (see set_log_level()); 0 also
+     *  suppresses the messages of the initialization.
      */
     CTMC(gsl_matrix * q, size_t ns,
-         bool log_path=false);
+         bool log_path=false, unsigned int log_level=1);
 
     ~CTMC();
 
@@ -68,6 +70,50 @@ class CTMC {
      */
     void burn_it_in();
 
+    /**
+     * Refresh the chain after rows of Q have been changed in place.
+     *
+     * The caller changes the entries of the given rows of the
+     * transition rate matrix Q that was handed to the constructor.
+     * Only the derived rows without diagonal elements and the exit
+     * rates of these rows are recomputed; the state of the chain is
+     * kept so that it can be used as a warm start.
+     *
+     * @param rows the rows of Q that have been changed.
+     */
+    void update_rows(const std::vector<state> & rows);
+
+    /**
+     * Reset time, jump counter and invariant distribution but keep
+     * the current state of the chain.
+     *
+     */
+    void reset_analysis();
+
+    /**
+     * Put the chain into the given state at time 0 and reset the
+     * analysis; used to start a new replicate without building a new
+     * chain.
+     *
+     * @param s the state.
+     */
+    void reset(state s);
+
+    /**
+     * Let the chain run and record its state at the given times.
+     *
+     * One trajectory is sampled at all times in a single pass; since
+     * the chain is Markov, the jump that would happen after the last
+     * time is discarded and the chain stops at that time.  Neither
+     * the path nor the invariant distribution are logged.
+     *
+     * @param times the times; ascending and not before the current
+     * time.
+     * @param states OUT; the state at each time.
+     */
+    void run_grid(const std::vector<double> & times,
+                  std::vector<state> & states);
+
     /**
      * Let the chain run for the given time.
      *
@@ -164,6 +210,8 @@ class CTMC {
     /// Transition rate matrix Q without diagonal elements.
     /// Internally used to determine the state to jump to.
     gsl_matrix * q_no_diagonal;
+    /// Exit rates -q_ii of the states.
+    double * exit_rates;
     /// Counter of jumps.
     unsigned int jump_counter;
     /// Number of burn in jumps.
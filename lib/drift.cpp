@@ -0,0 +1,252 @@
+#include "drift.h"
+#include "tools.h"
+
+#include <cmath>
+#include <thread>
+
+/// Number of replicates that a thread advances together.
+const size_t DRIFT_BATCH = 1024;
+
+FixationStats::FixationStats(unsigned long max_time, size_t n_bins):
+    n(0),
+    n_fixed(0),
+    mean(0),
+    m2(0),
+    hist(n_bins, 0)
+{
+    if (n_bins == 0) out_error("The histogram needs at least one bin.");
+    bin_width = max_time / n_bins;
+    if (bin_width == 0) bin_width = 1;
+}
+
+void FixationStats::reset() {
+    n = 0;
+    n_fixed = 0;
+    mean = 0;
+    m2 = 0;
+    for (size_t i = 0; i < hist.size(); i++) hist[i] = 0;
+}
+
+void FixationStats::add(bool fixed, unsigned long t) {
+    n++;
+    if (fixed) n_fixed++;
+    double delta = t - mean;
+    mean += delta / n;
+    m2 += delta * (t - mean);
+    size_t b = t / bin_width;
+    if (b >= hist.size()) b = hist.size() - 1;
+    hist[b]++;
+}
+
+void FixationStats::merge(const FixationStats & o) {
+    if (o.n == 0) return;
+    if (o.hist.size() != hist.size() || o.bin_width != bin_width)
+        out_error("Histograms do not match.");
+    // Parallel variance algorithm of Chan et al.
+    unsigned long n_new = n + o.n;
+    double delta = o.mean - mean;
+    m2 += o.m2 + delta * delta * ((double) n * o.n / n_new);
+    mean += delta * o.n / n_new;
+    n = n_new;
+    n_fixed += o.n_fixed;
+    for (size_t i = 0; i < hist.size(); i++) hist[i] += o.hist[i];
+}
+
+double FixationStats::fixation_probability() const {
+    if (n == 0) return 0;
+    return (double) n_fixed / n;
+}
+
+double FixationStats::var_time() const {
+    if (n < 2) return 0;
+    return m2 / (n - 1);
+}
+
+void FixationStats::print(std::ostream & out) const {
+    out << "Number of replicates: " << n << std::endl;
+    out << "Fixation probability of allele one: "
+        << fixation_probability() << std::endl;
+    out << "Mean time to fixation: " << mean_time() << std::endl;
+    out << "Variance of time to fixation: " << var_time() << std::endl;
+    out << "Histogram of fixation times:" << std::endl;
+    for (size_t i = 0; i < hist.size(); i++) {
+        out << std::setw(12) << i * bin_width;
+        if (i == hist.size() - 1) out << "+";
+        else out << " ";
+        out << std::setw(12) << hist[i] << std::endl;
+    }
+}
+
+DriftLoci::DriftLoci(unsigned int N, size_t n_loci, unsigned int k):
+    N(N),
+    n_loci(n_loci),
+    generation(0),
+    counts(n_loci, k),
+    n_fixed(0)
+{
+    if (k > N) out_error("More individuals with allele one than N.");
+    if (k > 0 && k < N) {
+        active_counts.assign(n_loci, k);
+        active.resize(n_loci);
+        for (size_t i = 0; i < n_loci; i++) active[i] = i;
+    }
+    else if (k == N) n_fixed = n_loci;
+    double x = (double) k / (double) N;
+    het_sum = n_loci * 2.0 * x * (1-x);
+    rg = new RanGen();
+}
+
+DriftLoci::~DriftLoci() {
+    delete rg;
+}
+
+void DriftLoci::evolve() {
+    size_t n_active = active.size();
+    size_t i = 0;
+    het_sum = 0;
+    while (i < n_active) {
+        double p = (double) active_counts[i] / (double) N;
+        unsigned int c = rg->pick_binomial(p, N);
+        if (c == 0 || c == N) {
+            // Write back and compact.
+            counts[active[i]] = c;
+            if (c == N) n_fixed++;
+            n_active--;
+            active_counts[i] = active_counts[n_active];
+            active[i] = active[n_active];
+            continue;
+        }
+        active_counts[i] = c;
+        double x = (double) c / (double) N;
+        het_sum += 2.0 * x * (1-x);
+        i++;
+    }
+    active_counts.resize(n_active);
+    active.resize(n_active);
+    generation++;
+}
+
+void DriftLoci::evolve(unsigned long n_gen) {
+    for (unsigned long g = 0; g < n_gen && !active.empty(); g++) evolve();
+}
+
+unsigned int DriftLoci::get_count(size_t locus) const {
+    if (locus >= n_loci) out_error("Locus out of range.");
+    // Segregating loci are only written back when they get fixed.
+    for (size_t i = 0; i < active.size(); i++)
+        if (active[i] == locus) return active_counts[i];
+    return counts[locus];
+}
+
+unsigned long drift_step_hybrid(unsigned int & k, unsigned int N,
+                                double eps, unsigned int k_exact,
+                                RanGen & rg) {
+    double x = (double) k / (double) N;
+    unsigned int m = k < N-k ? k : N-k;
+    double dt = 0;
+    if (eps > 0 && m >= k_exact) {
+        double h = (double) m / (double) N;
+        dt = std::floor(eps * eps * h * h * N / (x * (1-x)));
+    }
+    if (dt < 2) {
+        k = rg.pick_binomial(x, N);
+        return 1;
+    }
+    // Mean and variance of the frequency after dt generations:
+    // E[x'] = x, Var[x'] = x(1-x)(1-(1-1/N)^dt).
+    double var = x * (1-x) * -std::expm1(dt * std::log1p(-1.0/N));
+    double x_new = x + rg.pick_gaussian(std::sqrt(var));
+    double k_new = std::floor(x_new * N + 0.5);
+    if (k_new < 0) k_new = 0;
+    if (k_new > N) k_new = N;
+    k = (unsigned int) k_new;
+    return (unsigned long) dt;
+}
+
+/**
+ * Run a share of the replicates in one thread.
+ *
+ * A batch of replicates is kept in contiguous arrays.  Each pass
+ * advances all of them by one generation; fixed replicates are
+ * recorded and replaced by new ones until the share is done.
+ */
+void drift_replicates_thread(unsigned int N, unsigned int k,
+                             unsigned long n_reps, RanGen * rgp,
+                             double eps, unsigned int k_exact,
+                             FixationStats * stats) {
+    RanGen & rg = *rgp;
+    std::vector<unsigned int> counts(DRIFT_BATCH);
+    std::vector<unsigned long> times(DRIFT_BATCH);
+    unsigned long n_started = 0;
+    size_t n_active = 0;
+
+    for (;;) {
+        // Fill up the batch.
+        while (n_active < DRIFT_BATCH && n_started < n_reps) {
+            counts[n_active] = k;
+            times[n_active] = 0;
+            n_active++;
+            n_started++;
+        }
+        if (n_active == 0) break;
+        // One generation of all active replicates.
+        if (eps == 0) {
+            for (size_t i = 0; i < n_active; i++) {
+                double p = (double) counts[i] / (double) N;
+                counts[i] = rg.pick_binomial(p, N);
+                times[i]++;
+            }
+        }
+        else {
+            for (size_t i = 0; i < n_active; i++)
+                times[i] += drift_step_hybrid(counts[i], N, eps,
+                                              k_exact, rg);
+        }
+        // Record and remove fixed replicates.
+        size_t i = 0;
+        while (i < n_active) {
+            if (counts[i] == 0 || counts[i] == N) {
+                stats->add(counts[i] == N, times[i]);
+                n_active--;
+                counts[i] = counts[n_active];
+                times[i] = times[n_active];
+            }
+            else i++;
+        }
+    }
+}
+
+void drift_replicates(unsigned int N, unsigned int k,
+                      unsigned long n_reps, unsigned int n_threads,
+                      unsigned long seed, FixationStats & stats,
+                      double eps, unsigned int k_exact) {
+    if (k > N) out_error("More individuals with allele one than N.");
+    if (n_threads == 0) n_threads = 1;
+    // Replicates that start fixed.
+    if (k == 0 || k == N) {
+        for (unsigned long i = 0; i < n_reps; i++) stats.add(k == N, 0);
+        return;
+    }
+    std::vector<FixationStats> thread_stats(n_threads, stats);
+    // The constructor of RanGen sets global GSL defaults; initialize
+    // the generators before the threads start.
+    std::vector<RanGen*> rg;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        rg.push_back(new RanGen());
+        rg[t]->set_seed(seed + t);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        thread_stats[t].reset();
+        unsigned long share = n_reps / n_threads;
+        if (t < n_reps % n_threads) share++;
+        threads.push_back(std::thread(drift_replicates_thread, N, k,
+                                      share, rg[t], eps, k_exact,
+                                      &thread_stats[t]));
+    }
+    for (unsigned int t = 0; t < n_threads; t++) {
+        threads[t].join();
+        stats.merge(thread_stats[t]);
+        delete rg[t];
+    }
+}
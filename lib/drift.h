@@ -0,0 +1,228 @@
+/**
+ * @file   drift.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 13:41:18 2026
+ *
+ * @brief  Replicate simulations of genetic drift to fixation.
+ *
+ * Many independent biallelic Wright-Fisher populations are run until
+ * one of the alleles is fixed.  Only summary statistics are kept:
+ * the fixation probability of allele one, a histogram of the
+ * fixation times and the mean and variance of the fixation time.
+ * The replicates are distributed over threads; each thread has its
+ * own random number generator and advances a batch of replicates one
+ * generation at a time.
+ *
+ * For large N, the hybrid step advances intermediate frequencies by
+ * many generations at once with a Gaussian approximation of the
+ * Wright-Fisher diffusion and falls back to exact binomial sampling
+ * near the boundaries.  The number of steps per replicate then hardly
+ * depends on N.
+ *
+ * DriftLoci evolves many independent loci of one population in a
+ * single pass per generation.
+ *
+ */
+
+#ifndef DRIFT_H
+#define DRIFT_H
+
+#include <iostream>
+#include <vector>
+#include "ran_generator.h"
+
+/**
+ * Summary statistics of the fixation of replicate populations.
+ *
+ */
+class FixationStats {
+ public:
+    /**
+     * Initialize empty statistics.
+     *
+     * @param max_time fixation times from max_time on are collected
+     * in the last bin of the histogram.
+     * @param n_bins the number of bins of the histogram.
+     */
+    FixationStats(unsigned long max_time=1, size_t n_bins=1);
+
+    /**
+     * Add a replicate.
+     *
+     * @param fixed true if allele one has been fixed.
+     * @param t the number of generations to fixation.
+     */
+    void add(bool fixed, unsigned long t);
+
+    /**
+     * Remove all replicates but keep the histogram layout.
+     *
+     */
+    void reset();
+
+    /**
+     * Add the replicates of other statistics with the same histogram
+     * layout.
+     *
+     * @param o the other statistics.
+     */
+    void merge(const FixationStats & o);
+
+    /// The number of replicates.
+    unsigned long get_n() const { return n; }
+
+    /// The fraction of replicates in which allele one got fixed.
+    double fixation_probability() const;
+
+    /// The mean time to fixation.
+    double mean_time() const { return mean; }
+
+    /// The (sample) variance of the time to fixation.
+    double var_time() const;
+
+    /**
+     * Print the statistics and the histogram.
+     *
+     * @param out output stream.
+     */
+    void print(std::ostream & out) const;
+
+ private:
+    /// Number of replicates.
+    unsigned long n;
+    /// Number of replicates in which allele one got fixed.
+    unsigned long n_fixed;
+    /// Running mean of the fixation time (Welford).
+    double mean;
+    /// Running sum of squared deviations from the mean.
+    double m2;
+    /// Width of a histogram bin.
+    unsigned long bin_width;
+    /// Histogram of fixation times.
+    std::vector<unsigned long> hist;
+};
+
+/**
+ * Many independent biallelic loci of one population.
+ *
+ * The allele counts of the loci that still segregate are kept in a
+ * contiguous array together with their locus indices.  Each
+ * generation is one pass over this array.  Loci that get fixed are
+ * written back and removed by swapping in the last active locus, so
+ * fixed loci cost nothing.
+ */
+class DriftLoci {
+ public:
+    /**
+     * Initialize the loci.
+     *
+     * @param N the population size.
+     * @param n_loci the number of loci.
+     * @param k the initial number of individuals with allele one at
+     * each locus.
+     */
+    DriftLoci(unsigned int N, size_t n_loci, unsigned int k);
+
+    ~DriftLoci();
+
+    /**
+     * Evolve all loci one generation.
+     *
+     */
+    void evolve();
+
+    /**
+     * Evolve all loci for some generations or until no locus
+     * segregates anymore.
+     *
+     * @param n_gen the number of generations.
+     */
+    void evolve(unsigned long n_gen);
+
+    /**
+     * Get the number of individuals with allele one at a locus.
+     * This is a lookup in the segregating loci; it is meant for
+     * output, not for the inner loop.
+     *
+     * @param locus the locus.
+     *
+     * @return the allele count.
+     */
+    unsigned int get_count(size_t locus) const;
+
+    /// The number of generations evolved.
+    unsigned long get_generation() const { return generation; }
+
+    /// The number of loci that still segregate.
+    size_t n_segregating() const { return active.size(); }
+
+    /// The number of loci at which allele one has been fixed.
+    size_t n_fixed_one() const { return n_fixed; }
+
+    /// The mean expected heterozygosity 2x(1-x) over all loci.
+    double mean_heterozygosity() const { return het_sum / n_loci; }
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    /// Population size.
+    unsigned int N;
+    /// Number of loci.
+    size_t n_loci;
+    /// Number of generations evolved.
+    unsigned long generation;
+    /// Allele counts of the fixed loci.
+    std::vector<unsigned int> counts;
+    /// Allele counts of the segregating loci.
+    std::vector<unsigned int> active_counts;
+    /// Locus indices of the segregating loci.
+    std::vector<size_t> active;
+    /// Number of loci at which allele one has been fixed.
+    size_t n_fixed;
+    /// Sum of 2x(1-x) over the loci.
+    double het_sum;
+};
+
+/**
+ * Advance a population by one or more generations.
+ *
+ * Let m = min(k, N-k).  If m < k_exact, one exact Wright-Fisher
+ * generation is drawn.  Otherwise the number of generations dt is
+ * chosen such that the standard deviation of the frequency change,
+ * \f$ \sqrt{x(1-x)dt/N} \f$, is at most eps*m/N, and the frequency
+ * is advanced by a Gaussian step with the exact mean and variance
+ * of dt Wright-Fisher generations.  The error is controlled by eps;
+ * eps = 0 always takes exact steps.
+ *
+ * @param k IN/OUT; the number of individuals with allele one.
+ * @param N the population size.
+ * @param eps the relative size of a diffusion step.
+ * @param k_exact take exact steps if less than k_exact individuals
+ * carry the rarer allele.
+ * @param rg random number generator.
+ *
+ * @return the number of generations advanced.
+ */
+unsigned long drift_step_hybrid(unsigned int & k, unsigned int N,
+                                double eps, unsigned int k_exact,
+                                RanGen & rg);
+
+/**
+ * Run replicate populations to fixation.
+ *
+ * @param N the population size.
+ * @param k the initial number of individuals with allele one.
+ * @param n_reps the number of replicates.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param stats IN/OUT; the replicates are added.
+ * @param eps relative size of hybrid steps; 0 for exact steps only.
+ * @param k_exact see drift_step_hybrid().
+ */
+void drift_replicates(unsigned int N, unsigned int k,
+                      unsigned long n_reps, unsigned int n_threads,
+                      unsigned long seed, FixationStats & stats,
+                      double eps=0, unsigned int k_exact=100);
+
+#endif
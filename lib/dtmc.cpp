@@ -0,0 +1,237 @@
+#include "dtmc.h"
+#include "tools.h"
+
+#include <cmath>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+
+DTMC::DTMC(const gsl_matrix * p_in):
+    ns(p_in->size1),
+    nnz(0),
+    state_now(0),
+    n_ahead(0)
+{
+    if (p_in->size1 != p_in->size2 || ns == 0)
+        out_error("The transition probability matrix has to be square.");
+    p = gsl_matrix_alloc(ns, ns);
+    for (size_t i = 0; i < ns; i++) {
+        double sum = 0;
+        for (size_t j = 0; j < ns; j++) {
+            double x = gsl_matrix_get(p_in, i, j);
+            if (x < 0) out_error("Negative transition probability.");
+            sum += x;
+        }
+        if (sum <= 0) out_error("Row without transitions.");
+        for (size_t j = 0; j < ns; j++)
+            gsl_matrix_set(p, i, j, gsl_matrix_get(p_in, i, j) / sum);
+    }
+    build_rows(p, rows);
+    for (size_t i = 0; i < ns; i++) nnz += rows[i].cols.size();
+    rg = new RanGen();
+}
+
+DTMC::DTMC(size_t ns, const std::vector<std::vector<state> > & cols,
+           const std::vector<std::vector<double> > & probs):
+    ns(ns),
+    nnz(0),
+    state_now(0),
+    n_ahead(0)
+{
+    if (ns == 0 || cols.size() != ns || probs.size() != ns)
+        out_error("Wrong number of rows.");
+    p = gsl_matrix_calloc(ns, ns);
+    for (size_t i = 0; i < ns; i++) {
+        if (cols[i].size() != probs[i].size())
+            out_error("Wrong number of transition probabilities.");
+        double sum = 0;
+        for (size_t k = 0; k < cols[i].size(); k++) {
+            if (cols[i][k] >= ns) out_error("State out of range.");
+            if (probs[i][k] < 0) out_error("Negative transition probability.");
+            sum += probs[i][k];
+        }
+        if (sum <= 0) out_error("Row without transitions.");
+        for (size_t k = 0; k < cols[i].size(); k++)
+            *gsl_matrix_ptr(p, i, cols[i][k]) += probs[i][k] / sum;
+    }
+    build_rows(p, rows);
+    for (size_t i = 0; i < ns; i++) nnz += rows[i].cols.size();
+    rg = new RanGen();
+}
+
+DTMC::~DTMC() {
+    delete rg;
+    free_rows(rows);
+    free_rows(rows_ahead);
+    gsl_matrix_free(p);
+}
+
+void DTMC::build_rows(const gsl_matrix * m, std::vector<row> & r) const {
+    r.resize(ns);
+    std::vector<double> w;
+    for (size_t i = 0; i < ns; i++) {
+        r[i].cols.clear();
+        w.clear();
+        for (size_t j = 0; j < ns; j++) {
+            // Rounding in P^n may leave tiny negative entries.
+            double x = gsl_matrix_get(m, i, j);
+            if (x > 0) {
+                r[i].cols.push_back(j);
+                w.push_back(x);
+            }
+        }
+        r[i].table = gsl_ran_discrete_preproc(w.size(), &w[0]);
+    }
+}
+
+void DTMC::free_rows(std::vector<row> & r) const {
+    for (size_t i = 0; i < r.size(); i++)
+        gsl_ran_discrete_free(r[i].table);
+    r.clear();
+}
+
+void DTMC::set_state(state s) {
+    if (s >= ns) out_error("State out of range.");
+    state_now = s;
+}
+
+state DTMC::run(unsigned long n, std::vector<unsigned long> & occupancy) {
+    if (occupancy.size() != ns) occupancy.assign(ns, 0);
+    for (unsigned long k = 0; k < n; k++) occupancy[jump()]++;
+    return state_now;
+}
+
+void DTMC::power(unsigned long n, gsl_matrix * out) const {
+    gsl_matrix * base = gsl_matrix_alloc(ns, ns);
+    gsl_matrix * tmp = gsl_matrix_alloc(ns, ns);
+    gsl_matrix_memcpy(base, p);
+    gsl_matrix_set_identity(out);
+    while (n > 0) {
+        if (n & 1) {
+            gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, out, base, 0.0, tmp);
+            gsl_matrix_memcpy(out, tmp);
+        }
+        n >>= 1;
+        if (n > 0) {
+            gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, base, base, 0.0, tmp);
+            gsl_matrix_memcpy(base, tmp);
+        }
+    }
+    gsl_matrix_free(base);
+    gsl_matrix_free(tmp);
+}
+
+void DTMC::distribution(unsigned long n, std::vector<double> & d) const {
+    if (d.size() != ns) out_error("Wrong length of the distribution.");
+    // Sparse propagation costs n*nnz, squaring about 2*log2(n)*ns^3.
+    double cost_sparse = (double) n * nnz;
+    double cost_dense = 2.0 * std::log((double) n + 1) / std::log(2.0)
+        * ns * ns * ns;
+    if (cost_sparse <= cost_dense) {
+        std::vector<double> next(ns);
+        for (unsigned long k = 0; k < n; k++) {
+            next.assign(ns, 0);
+            for (size_t i = 0; i < ns; i++) {
+                if (d[i] == 0) continue;
+                for (size_t l = 0; l < rows[i].cols.size(); l++) {
+                    state j = rows[i].cols[l];
+                    next[j] += d[i] * gsl_matrix_get(p, i, j);
+                }
+            }
+            d.swap(next);
+        }
+    }
+    else {
+        gsl_matrix * pn = gsl_matrix_alloc(ns, ns);
+        power(n, pn);
+        std::vector<double> next(ns, 0);
+        for (size_t i = 0; i < ns; i++)
+            if (d[i] != 0)
+                for (size_t j = 0; j < ns; j++)
+                    next[j] += d[i] * gsl_matrix_get(pn, i, j);
+        d.swap(next);
+        gsl_matrix_free(pn);
+    }
+}
+
+state DTMC::jump_ahead(unsigned long n) {
+    if (n == 0) return state_now;
+    if (n == 1) return jump();
+    if (n != n_ahead) {
+        gsl_matrix * pn = gsl_matrix_alloc(ns, ns);
+        power(n, pn);
+        free_rows(rows_ahead);
+        build_rows(pn, rows_ahead);
+        gsl_matrix_free(pn);
+        n_ahead = n;
+    }
+    const row & r = rows_ahead[state_now];
+    state_now = r.cols[rg->pick_discrete(r.table)];
+    return state_now;
+}
+
+void DTMC::fundamental_matrix(const std::vector<state> & absorbing,
+                              gsl_matrix * n) const {
+    std::vector<bool> is_absorbing(ns, false);
+    for (size_t k = 0; k < absorbing.size(); k++) {
+        if (absorbing[k] >= ns) out_error("State out of range.");
+        is_absorbing[absorbing[k]] = true;
+    }
+    std::vector<state> transient;
+    for (size_t i = 0; i < ns; i++)
+        if (!is_absorbing[i]) transient.push_back(i);
+    gsl_matrix_set_zero(n);
+    size_t nt = transient.size();
+    if (nt == 0) return;
+
+    // I-Q on the transient states.
+    gsl_matrix * a = gsl_matrix_alloc(nt, nt);
+    gsl_matrix * inv = gsl_matrix_alloc(nt, nt);
+    gsl_permutation * perm = gsl_permutation_alloc(nt);
+    for (size_t i = 0; i < nt; i++)
+        for (size_t j = 0; j < nt; j++)
+            gsl_matrix_set(a, i, j, (i == j ? 1.0 : 0.0)
+                           - gsl_matrix_get(p, transient[i], transient[j]));
+    int signum;
+    gsl_linalg_LU_decomp(a, perm, &signum);
+    for (size_t i = 0; i < nt; i++)
+        if (std::fabs(gsl_matrix_get(a, i, i)) < 1e-12)
+            out_error("Some transient states are never absorbed.");
+    gsl_linalg_LU_invert(a, perm, inv);
+    for (size_t i = 0; i < nt; i++)
+        for (size_t j = 0; j < nt; j++)
+            gsl_matrix_set(n, transient[i], transient[j],
+                           gsl_matrix_get(inv, i, j));
+    gsl_matrix_free(a);
+    gsl_matrix_free(inv);
+    gsl_permutation_free(perm);
+}
+
+void DTMC::absorption_times(const std::vector<state> & absorbing,
+                            std::vector<double> & t) const {
+    gsl_matrix * n = gsl_matrix_alloc(ns, ns);
+    fundamental_matrix(absorbing, n);
+    t.assign(ns, 0);
+    for (size_t i = 0; i < ns; i++)
+        for (size_t j = 0; j < ns; j++) t[i] += gsl_matrix_get(n, i, j);
+    gsl_matrix_free(n);
+}
+
+double DTMC::return_time(state s) const {
+    std::vector<double> t;
+    absorption_times(std::vector<state>(1, s), t);
+    // One step, then the time to absorption in s.
+    double r = 1;
+    for (size_t j = 0; j < ns; j++) r += gsl_matrix_get(p, s, j) * t[j];
+    return r;
+}
+
+double DTMC::visits_before_return(state s, state o) const {
+    if (o == s) out_error("The visited state has to differ from the start.");
+    gsl_matrix * n = gsl_matrix_alloc(ns, ns);
+    fundamental_matrix(std::vector<state>(1, s), n);
+    double v = 0;
+    for (size_t j = 0; j < ns; j++)
+        v += gsl_matrix_get(p, s, j) * gsl_matrix_get(n, j, o);
+    gsl_matrix_free(n);
+    return v;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file   dtmc.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 22:52:37 2026
+ *
+ * @brief  A class to run a discrete-time Markov chain (DTMC).
+ *
+ * The rows of the transition probability matrix P are stored sparse:
+ * for each state, the states that can be reached and an alias table
+ * (gsl_ran_discrete_t) over their probabilities, so that a step
+ * costs O(1) independent of the number of states.
+ *
+ * Exact n-step distributions are computed either by propagating a
+ * distribution through the sparse rows, n times, or by repeated
+ * squaring of the dense P (log2(n) matrix products with
+ * gsl_blas_dgemm), whichever is cheaper.  jump_ahead() samples the
+ * state after n steps directly from the row of P^n.
+ *
+ * For absorbing chains, where a set of states is made absorbing, the
+ * fundamental matrix N = (I-Q)^-1 is computed with an LU
+ * decomposition, where Q is P restricted to the other (transient)
+ * states.  Entry (i,j) of N is the expected number of visits to j
+ * before absorption when starting in i (the start counts), and the
+ * row sums are the expected times to absorption.  Return times and
+ * visits before the return follow from one more step.
+ *
+ */
+
+#ifndef DTMC_H
+#define DTMC_H
+
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_randist.h>
+#include "ran_generator.h"
+
+typedef unsigned int state;
+
+class DTMC {
+ public:
+    /**
+     * Initialize the chain with a dense transition probability
+     * matrix; the matrix is copied.
+     *
+     * @param p the transition probability matrix P; the rows need
+     * not be normalized.
+     */
+    DTMC(const gsl_matrix * p);
+
+    /**
+     * Initialize the chain with sparse rows.
+     *
+     * @param ns the number of states.
+     * @param cols the states that can be reached from each state.
+     * @param probs the corresponding transition probabilities.
+     */
+    DTMC(size_t ns, const std::vector<std::vector<state> > & cols,
+         const std::vector<std::vector<double> > & probs);
+
+    ~DTMC();
+
+    /// Set the current state.
+    void set_state(state s);
+
+    /// The current state.
+    state get_state() const { return state_now; }
+
+    /// The number of states.
+    size_t get_n_states() const { return ns; }
+
+    /// Perform one step.
+    state jump() {
+        const row & r = rows[state_now];
+        state_now = r.cols[rg->pick_discrete(r.table)];
+        return state_now;
+    }
+
+    /**
+     * Perform several steps and count the visits to each state (after
+     * each step).
+     *
+     * @param n the number of steps.
+     * @param occupancy IN/OUT; the counts are added, length ns.
+     *
+     * @return the state the chain ends up in.
+     */
+    state run(unsigned long n, std::vector<unsigned long> & occupancy);
+
+    /**
+     * Compute P^n.
+     *
+     * @param n the power.
+     * @param out OUT; ns-by-ns.
+     */
+    void power(unsigned long n, gsl_matrix * out) const;
+
+    /**
+     * The exact distribution after n steps.
+     *
+     * @param n the number of steps.
+     * @param p IN/OUT; the initial distribution, replaced by the
+     * distribution after n steps; length ns.
+     */
+    void distribution(unsigned long n, std::vector<double> & p) const;
+
+    /**
+     * Sample the state after n steps from the row of P^n.  The
+     * tables of P^n are kept, so that jumping ahead repeatedly by the
+     * same n costs one step each.
+     *
+     * @param n the number of steps.
+     *
+     * @return the new state.
+     */
+    state jump_ahead(unsigned long n);
+
+    /**
+     * Compute the fundamental matrix of the chain with absorbing
+     * states.
+     *
+     * @param absorbing the absorbing states; every transient state
+     * has to reach one of them.
+     * @param n OUT; ns-by-ns; rows and columns of absorbing states
+     * are zero.
+     */
+    void fundamental_matrix(const std::vector<state> & absorbing,
+                            gsl_matrix * n) const;
+
+    /**
+     * Compute the expected number of steps to absorption.
+     *
+     * @param absorbing the absorbing states.
+     * @param t OUT; the expected time from each state, 0 for
+     * absorbing states; length ns.
+     */
+    void absorption_times(const std::vector<state> & absorbing,
+                          std::vector<double> & t) const;
+
+    /**
+     * The expected number of steps until the chain returns to s.
+     *
+     * @param s the state.
+     */
+    double return_time(state s) const;
+
+    /**
+     * The expected number of visits to state o before the chain
+     * returns to s.
+     *
+     * @param s the start state.
+     * @param o the visited state; distinct from s.
+     */
+    double visits_before_return(state s, state o) const;
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    struct row {
+        std::vector<state> cols;
+        gsl_ran_discrete_t * table;
+    };
+    /// Build the sparse rows from the dense matrix.
+    void build_rows(const gsl_matrix * m, std::vector<row> & r) const;
+    /// Free the tables of sparse rows.
+    void free_rows(std::vector<row> & r) const;
+    /// Number of states.
+    size_t ns;
+    /// Number of nonzero transition probabilities.
+    size_t nnz;
+    /// Current state.
+    state state_now;
+    /// Normalized transition probability matrix P.
+    gsl_matrix * p;
+    /// Sparse rows of P.
+    std::vector<row> rows;
+    /// Sparse rows of P^n for jump_ahead(), and n; 0 if not built.
+    std::vector<row> rows_ahead;
+    unsigned long n_ahead;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "forward_wf.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// Number of set bits of a word.
+inline unsigned int popcount(uint64_t w) {
+    return __builtin_popcountll(w);
+}
+
+ForwardWF::ForwardWF(unsigned int N, unsigned int n_sel, double s,
+                     double r, double u, unsigned int simplify_interval):
+    N(N),
+    n_sel(n_sel),
+    s(s),
+    r(r),
+    u(u),
+    simplify_interval(simplify_interval),
+    generation(0),
+    ts(1.0),
+    sampled(false)
+{
+    if (N == 0) out_error("Population size has to be positive.");
+    if (simplify_interval == 0) this->simplify_interval = 1;
+    n_words = (n_sel + 63) / 64;
+    if (n_words == 0) n_words = 1;
+    genomes.assign((size_t) N * n_words, 0);
+    genomes_next.assign((size_t) N * n_words, 0);
+    nodes.resize(N);
+    nodes_next.resize(N);
+    fitness.resize(N);
+    mask.resize(n_words);
+    for (unsigned int i = 0; i < N; i++) nodes[i] = ts.add_node(0);
+    rg = new RanGen();
+}
+
+ForwardWF::~ForwardWF() {
+    delete rg;
+}
+
+void ForwardWF::set_allele(unsigned int i, unsigned int site,
+                           bool derived) {
+    if (i >= N || site >= n_sel) out_error("Genome or site out of range.");
+    uint64_t bit = (uint64_t) 1 << (site % 64);
+    uint64_t & w = genomes[(size_t) i * n_words + site / 64];
+    if (derived) w |= bit;
+    else w &= ~bit;
+}
+
+double ForwardWF::derived_frequency(unsigned int site) const {
+    if (site >= n_sel) out_error("Site out of range.");
+    unsigned int c = 0;
+    for (unsigned int i = 0; i < N; i++)
+        c += (genomes[(size_t) i * n_words + site / 64] >> (site % 64)) & 1;
+    return (double) c / N;
+}
+
+void ForwardWF::evolve() {
+    if (sampled) out_error("The population has been reduced to a sample.");
+    unsigned int i, k;
+    // Selection.
+    double log_w = std::log1p(s);
+    for (i = 0; i < N; i++) {
+        unsigned int d = 0;
+        for (k = 0; k < n_words; k++)
+            d += popcount(genomes[(size_t) i * n_words + k]);
+        fitness[i] = std::exp(d * log_w);
+    }
+    gsl_ran_discrete_t * g = gsl_ran_discrete_preproc(N, &fitness[0]);
+
+    double t = generation + 1;
+    std::vector<double> breaks;
+    for (i = 0; i < N; i++) {
+        unsigned int p1 = rg->pick_discrete(g);
+        unsigned int p2 = rg->pick_discrete(g);
+        const uint64_t * g1 = &genomes[(size_t) p1 * n_words];
+        const uint64_t * g2 = &genomes[(size_t) p2 * n_words];
+        uint64_t * c = &genomes_next[(size_t) i * n_words];
+        int node = ts.add_node(t);
+        nodes_next[i] = node;
+
+        // Recombination.  Sites at positions (j+0.5)/n_sel right of
+        // an odd number of crossovers come from the second parent.
+        breaks.clear();
+        unsigned int n_co = r > 0 ? rg->pick_poisson(r) : 0;
+        for (k = 0; k < n_co; k++) breaks.push_back(rg->pick_uniform());
+        std::sort(breaks.begin(), breaks.end());
+        for (k = 0; k < n_words; k++) mask[k] = 0;
+        for (k = 0; k < n_co; k++) {
+            double j_d = std::ceil(breaks[k] * n_sel - 0.5);
+            unsigned int j = j_d < 0 ? 0 : (unsigned int) j_d;
+            if (j >= n_sel) continue;
+            // Flip all sites from j on.
+            mask[j / 64] ^= ~(uint64_t) 0 << (j % 64);
+            for (unsigned int w = j / 64 + 1; w < n_words; w++)
+                mask[w] = ~mask[w];
+        }
+        for (k = 0; k < n_words; k++)
+            c[k] = (g1[k] & ~mask[k]) | (g2[k] & mask[k]);
+
+        // Record the inherited intervals.
+        double left = 0;
+        for (k = 0; k <= n_co; k++) {
+            double right = k < n_co ? breaks[k] : 1.0;
+            if (right > left)
+                ts.add_edge(left, right, k % 2 == 0 ? nodes[p1] : nodes[p2],
+                            node);
+            left = right;
+        }
+
+        // Mutation.
+        unsigned int n_mut = u > 0 ? rg->pick_poisson(u * n_sel) : 0;
+        for (k = 0; k < n_mut; k++) {
+            unsigned int j = rg->pick_uniform_int(n_sel);
+            c[j / 64] ^= (uint64_t) 1 << (j % 64);
+        }
+    }
+    gsl_ran_discrete_free(g);
+
+    genomes.swap(genomes_next);
+    nodes.swap(nodes_next);
+    generation++;
+    if (generation % simplify_interval == 0) simplify();
+}
+
+void ForwardWF::evolve(unsigned long n_gen) {
+    for (unsigned long g = 0; g < n_gen; g++) evolve();
+}
+
+void ForwardWF::simplify() {
+    ts.simplify(nodes);
+    for (unsigned int i = 0; i < N; i++) nodes[i] = i;
+}
+
+TreeSequence & ForwardWF::sample(unsigned int n) {
+    if (n > N) out_error("Sample larger than population.");
+    std::vector<int> samples(nodes.begin(), nodes.begin() + n);
+    ts.simplify(samples);
+    if (n < N) sampled = true;
+    else for (unsigned int i = 0; i < N; i++) nodes[i] = i;
+    return ts;
+}
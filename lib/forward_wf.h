@@ -0,0 +1,138 @@
+/**
+ * @file   forward_wf.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 17:02:13 2026
+ *
+ * @brief  Individual-based forward Wright-Fisher simulation with
+ * selection, recombination and tree sequence recording.
+ *
+ * The population consists of N haploid genomes on the interval [0,
+ * 1).  Only the selected sites are simulated explicitly; they are
+ * evenly spaced and the alleles of a genome are packed into 64 bit
+ * words (one bit per site, 1 is the derived allele).  Fitness is
+ * multiplicative, \f$ (1+s)^d \f$ for d derived alleles.
+ *
+ * Each generation, every offspring picks two parents with
+ * probabilities proportional to fitness.  The number of crossovers
+ * is Poisson with mean r and their positions are uniform; the
+ * offspring copies the first parent up to the first crossover, the
+ * second one up to the next, and so on.  Mutations flip the alleles
+ * of selected sites.  The inherited intervals are recorded as edges
+ * of a TreeSequence which is simplified periodically, so that memory
+ * and time scale with the retained ancestry and not with the number
+ * of neutral sites.
+ *
+ */
+
+#ifndef FORWARD_WF_H
+#define FORWARD_WF_H
+
+#include <vector>
+#include <stdint.h>
+#include "ran_generator.h"
+#include "tree_sequence.h"
+
+class ForwardWF {
+ public:
+    /**
+     * Initialize a population without derived alleles.
+     *
+     * @param N the number of haploid genomes.
+     * @param n_sel the number of selected sites.
+     * @param s the selection coefficient of a derived allele.
+     * @param r the expected number of crossovers per genome and
+     * generation.
+     * @param u the mutation rate per selected site and generation.
+     * @param simplify_interval simplify every that many generations.
+     */
+    ForwardWF(unsigned int N, unsigned int n_sel, double s, double r,
+              double u, unsigned int simplify_interval=100);
+
+    ~ForwardWF();
+
+    /**
+     * Evolve the population one generation.
+     *
+     */
+    void evolve();
+
+    /**
+     * Evolve the population for some generations.
+     *
+     * @param n_gen the number of generations.
+     */
+    void evolve(unsigned long n_gen);
+
+    /**
+     * Set the allele of a selected site in a genome.
+     *
+     * @param i the genome.
+     * @param site the selected site.
+     * @param derived true for the derived allele.
+     */
+    void set_allele(unsigned int i, unsigned int site, bool derived);
+
+    /**
+     * The frequency of the derived allele at a selected site.
+     *
+     * @param site the selected site.
+     *
+     * @return the frequency.
+     */
+    double derived_frequency(unsigned int site) const;
+
+    /**
+     * Simplify the tree sequence with respect to the first n genomes
+     * of the current generation.  Afterwards, the genome i is the
+     * node i of the tree sequence.  If n < N, the population can not
+     * evolve anymore.
+     *
+     * @param n the number of sampled genomes.
+     *
+     * @return the tree sequence.
+     */
+    TreeSequence & sample(unsigned int n);
+
+    /// The number of generations evolved.
+    unsigned long get_generation() const { return generation; }
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    /// Simplify with respect to the current generation.
+    void simplify();
+    /// Number of genomes.
+    unsigned int N;
+    /// Number of selected sites.
+    unsigned int n_sel;
+    /// Number of 64 bit words per genome.
+    unsigned int n_words;
+    /// Selection coefficient.
+    double s;
+    /// Expected number of crossovers.
+    double r;
+    /// Mutation rate per selected site.
+    double u;
+    /// Generations between simplifications.
+    unsigned int simplify_interval;
+    /// Generations evolved.
+    unsigned long generation;
+    /// Genomes of the current and next generation; genome i occupies
+    /// the words i*n_words, ..., (i+1)*n_words-1.
+    std::vector<uint64_t> genomes;
+    std::vector<uint64_t> genomes_next;
+    /// Tree sequence nodes of the current and next generation.
+    std::vector<int> nodes;
+    std::vector<int> nodes_next;
+    /// Fitness of the genomes.
+    std::vector<double> fitness;
+    /// Crossover mask of one offspring.
+    std::vector<uint64_t> mask;
+    /// Recorded genealogy.
+    TreeSequence ts;
+    /// True if the population has been reduced to a sample.
+    bool sampled;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "gen_cache.h"
+#include "tools.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/// Header of a cache file.  It is padded to 64 bytes so that the
+/// matrix entries that follow are aligned.
+struct gen_cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t key;
+    uint64_t size1;
+    uint64_t size2;
+    char padding[24];
+};
+
+const char GEN_CACHE_MAGIC[8] = {'P','G','G','E','N','M','A','T'};
+
+GenCache::GenCache(const char * dir):
+    dir(dir)
+{
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        out_warning("Could not create cache directory " + this->dir + ".");
+}
+
+GenCache::~GenCache() {
+    std::map<gsl_matrix *, std::pair<void *, size_t> >::iterator it;
+    for (it = maps.begin(); it != maps.end(); it++) {
+        munmap(it->second.first, it->second.second);
+        delete it->first;
+    }
+}
+
+uint64_t GenCache::key(const char * model, const double * params,
+                       size_t n_params) {
+    uint64_t h = 14695981039346656037ULL;
+    const unsigned char * b = (const unsigned char *) model;
+    for (size_t i = 0; b[i] != 0; i++) {
+        h ^= b[i];
+        h *= 1099511628211ULL;
+    }
+    b = (const unsigned char *) params;
+    for (size_t i = 0; i < n_params * sizeof(double); i++) {
+        h ^= b[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= GEN_CACHE_VERSION;
+    return h;
+}
+
+std::string GenCache::path(uint64_t k) {
+    char fn[32];
+    snprintf(fn, sizeof(fn), "%016llx.gen", (unsigned long long) k);
+    return dir + "/" + fn;
+}
+
+gsl_matrix * GenCache::load(uint64_t k) {
+    std::string fn = path(k);
+    int fd = open(fn.c_str(), O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(gen_cache_header)) {
+        close(fd);
+        return NULL;
+    }
+    size_t len = st.st_size;
+    void * p = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+
+    const gen_cache_header * hd = (const gen_cache_header *) p;
+    if (memcmp(hd->magic, GEN_CACHE_MAGIC, sizeof(GEN_CACHE_MAGIC)) != 0 ||
+        hd->version != GEN_CACHE_VERSION ||
+        hd->kind != GEN_CACHE_DENSE ||
+        hd->key != k ||
+        len != sizeof(gen_cache_header) +
+        hd->size1 * hd->size2 * sizeof(double)) {
+        out_warning("Invalid cache file " + fn + "; ignoring it.");
+        munmap(p, len);
+        return NULL;
+    }
+
+    // A matrix that does not own its data; the entries live in the
+    // mapped file.
+    gsl_matrix * m = new gsl_matrix;
+    m->size1 = hd->size1;
+    m->size2 = hd->size2;
+    m->tda = hd->size2;
+    m->data = (double *) ((char *) p + sizeof(gen_cache_header));
+    m->block = NULL;
+    m->owner = 0;
+    maps[m] = std::make_pair(p, len);
+    return m;
+}
+
+bool GenCache::store(uint64_t k, const gsl_matrix * m) {
+    std::string fn = path(k);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp.%ld", (long) getpid());
+    std::string fn_tmp = fn + suffix;
+
+    gen_cache_header hd;
+    memset(&hd, 0, sizeof(hd));
+    memcpy(hd.magic, GEN_CACHE_MAGIC, sizeof(GEN_CACHE_MAGIC));
+    hd.version = GEN_CACHE_VERSION;
+    hd.kind = GEN_CACHE_DENSE;
+    hd.key = k;
+    hd.size1 = m->size1;
+    hd.size2 = m->size2;
+
+    FILE * f = fopen(fn_tmp.c_str(), "wb");
+    if (f == NULL) {
+        out_warning("Could not write cache file " + fn_tmp + ".");
+        return false;
+    }
+    bool ok = fwrite(&hd, sizeof(hd), 1, f) == 1;
+    for (size_t i = 0; ok && i < m->size1; i++)
+        ok = fwrite(m->data + i * m->tda, sizeof(double), m->size2, f)
+            == m->size2;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(fn_tmp.c_str(), fn.c_str()) != 0) {
+        out_warning("Could not write cache file " + fn + ".");
+        unlink(fn_tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void GenCache::release(gsl_matrix * m) {
+    std::map<gsl_matrix *, std::pair<void *, size_t> >::iterator it =
+        maps.find(m);
+    if (it == maps.end()) {
+        out_warning("Matrix has not been loaded from the cache.");
+        return;
+    }
+    munmap(it->second.first, it->second.second);
+    delete it->first;
+    maps.erase(it);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file   gen_cache.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 10:12:37 2026
+ *
+ * @brief  An on-disk cache of assembled transition rate matrices.
+ *
+ * Matrices are stored in a versioned binary format in a cache
+ * directory.  The file name is a hash of the model name and its
+ * parameters.  Loaded matrices are memory mapped read-only, so that
+ * several processes on one node share the same physical pages.
+ *
+ */
+
+#ifndef GEN_CACHE_H
+#define GEN_CACHE_H
+
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <gsl/gsl_matrix.h>
+
+/// Version of the binary format; increase on incompatible changes.
+const uint32_t GEN_CACHE_VERSION = 1;
+
+/// Storage type of a cached matrix.  Only dense matrices exist so
+/// far, the field is reserved for sparse storage.
+enum gen_cache_kind { GEN_CACHE_DENSE = 0 };
+
+class GenCache {
+ public:
+    /**
+     * Initialize the cache.
+     *
+     * @param dir the cache directory; it is created if necessary.
+     */
+    GenCache(const char * dir);
+
+    /**
+     * Unmap all matrices that have been loaded and not released.
+     *
+     */
+    ~GenCache();
+
+    /**
+     * Compute the key of a model with given parameters.
+     *
+     * @param model the name of the model.
+     * @param params the parameters.
+     * @param n_params the number of parameters.
+     *
+     * @return the key (64 bit FNV-1a hash).
+     */
+    static uint64_t key(const char * model, const double * params,
+                        size_t n_params);
+
+    /**
+     * Load a matrix from the cache.
+     *
+     * The returned matrix is mapped read-only; writing to it causes a
+     * segmentation fault.  Copy it with gsl_matrix_memcpy() before
+     * changing entries.  Free it with release().
+     *
+     * @param k the key.
+     *
+     * @return the matrix or NULL if it is not in the cache.
+     */
+    gsl_matrix * load(uint64_t k);
+
+    /**
+     * Store a matrix in the cache.  Concurrent writers are safe; the
+     * file is written to a temporary file and renamed afterwards.
+     *
+     * @param k the key.
+     * @param m the matrix.
+     *
+     * @return true if the matrix has been stored.
+     */
+    bool store(uint64_t k, const gsl_matrix * m);
+
+    /**
+     * Unmap a matrix that has been loaded with load().
+     *
+     * @param m the matrix.
+     */
+    void release(gsl_matrix * m);
+
+ private:
+    /// Path of the cache file of a key.
+    std::string path(uint64_t k);
+    /// The cache directory.
+    std::string dir;
+    /// Loaded matrices with their mapped memory and its length.
+    std::map<gsl_matrix *, std::pair<void *, size_t> > maps;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "lattice.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+/// Offsets of the neighbors of the hexagonal torus.
+static const int hex_di[6] = {-1, -1, 0, 1, 1, 0};
+static const int hex_dj[6] = {0, 1, 1, 0, -1, -1};
+/// Offsets of the neighbors of the cubic torus.
+static const int cube_d[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                                 {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+/// Offsets of the eight neighbors of the torus (see stepping_stone.h).
+static const int torus8_di[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+static const int torus8_dj[8] = {-1, -1, -1, 0, 1, 1, 1, 0};
+
+/// Spread the bits of x so that there are s-1 zeroes between them.
+static uint64_t spread_bits(uint64_t x, unsigned int s) {
+    uint64_t r = 0;
+    for (unsigned int b = 0; b * s < 64 && b < 32; b++)
+        r |= ((x >> b) & 1) << (b * s);
+    return r;
+}
+
+/// Coordinate c plus o on a ring of length l.
+static inline unsigned int wrap(unsigned int c, int o, unsigned int l) {
+    int v = (int) c + o;
+    if (v < 0) v += l;
+    else if (v >= (int) l) v -= l;
+    return v;
+}
+
+Lattice::Lattice(lattice_type type, unsigned int l, bool morton):
+    type(type),
+    side(l),
+    regular(true)
+{
+    if (l < 2) out_error("The side length has to be at least two.");
+    switch (type) {
+    case LATTICE_TORUS:
+        dim = 2;
+        build(8, morton);
+        break;
+    case LATTICE_HEXAGONAL:
+        dim = 2;
+        build(6, morton);
+        break;
+    case LATTICE_CUBIC:
+        dim = 3;
+        build(6, morton);
+        break;
+    default:
+        out_error("Unknown lattice type.");
+    }
+}
+
+void Lattice::build(unsigned int deg, bool morton) {
+    unsigned long n = dim == 2 ? (unsigned long) side * side
+        : (unsigned long) side * side * side;
+    if (n * deg >= 0xffffffffUL) out_error("Lattice too large.");
+
+    // Numbering of the sites.
+    std::vector<uint32_t> order(n);
+    for (unsigned long r = 0; r < n; r++) order[r] = r;
+    if (morton) {
+        std::vector<uint64_t> key(n);
+        for (unsigned long r = 0; r < n; r++) {
+            if (dim == 2)
+                key[r] = spread_bits(r / side, 2) << 1
+                    | spread_bits(r % side, 2);
+            else
+                key[r] = spread_bits(r / side / side, 3) << 2
+                    | spread_bits(r / side % side, 3) << 1
+                    | spread_bits(r % side, 3);
+        }
+        std::sort(order.begin(), order.end(),
+                  [&key](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+        grid.resize(n);
+        for (unsigned long v = 0; v < n; v++) grid[order[v]] = v;
+    }
+
+    offsets.resize(n + 1);
+    neighbors.resize(n * deg);
+    for (unsigned long v = 0; v < n; v++) {
+        unsigned long r = order[v];
+        offsets[v] = v * deg;
+        for (unsigned int k = 0; k < deg; k++) {
+            unsigned long nr;
+            if (type == LATTICE_TORUS)
+                nr = (unsigned long) wrap(r / side, torus8_di[k], side) * side
+                    + wrap(r % side, torus8_dj[k], side);
+            else if (type == LATTICE_HEXAGONAL)
+                nr = (unsigned long) wrap(r / side, hex_di[k], side) * side
+                    + wrap(r % side, hex_dj[k], side);
+            else
+                nr = ((unsigned long) wrap(r / side / side, cube_d[k][0], side)
+                      * side + wrap(r / side % side, cube_d[k][1], side))
+                    * side + wrap(r % side, cube_d[k][2], side);
+            neighbors[v * deg + k] = grid_site(nr);
+        }
+    }
+    offsets[n] = n * deg;
+}
+
+Lattice::Lattice(const char * fn):
+    type(LATTICE_GRAPH),
+    dim(0),
+    side(0)
+{
+    std::ifstream in(fn);
+    if (!in)
+        out_error((std::string("Cannot open edge list ") + fn + ".").c_str());
+    std::vector<std::pair<uint32_t, uint32_t> > edges;
+    unsigned long n = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ls(line);
+        unsigned long a, b;
+        if (!(ls >> a >> b)) out_error("Malformed edge list.");
+        // Site numbers are stored as uint32_t.
+        if (a >= UINT32_MAX || b >= UINT32_MAX)
+            out_error("Site number out of range in edge list.");
+        if (a == b) continue;
+        edges.push_back(std::make_pair(a, b));
+        n = std::max(n, std::max(a, b) + 1);
+    }
+    if (edges.empty()) out_error("The graph has no edges.");
+
+    std::vector<uint64_t> deg(n, 0);
+    for (size_t e = 0; e < edges.size(); e++) {
+        deg[edges[e].first]++;
+        deg[edges[e].second]++;
+    }
+    offsets.assign(n + 1, 0);
+    for (unsigned long x = 0; x < n; x++) {
+        if (deg[x] == 0) out_error("The graph has an isolated site.");
+        offsets[x+1] = offsets[x] + deg[x];
+    }
+    neighbors.resize(offsets[n]);
+    std::vector<uint64_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < edges.size(); e++) {
+        neighbors[fill[edges[e].first]++] = edges[e].second;
+        neighbors[fill[edges[e].second]++] = edges[e].first;
+    }
+    regular = true;
+    for (unsigned long x = 1; x < n; x++)
+        if (deg[x] != deg[0]) regular = false;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file   lattice.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 20:31:08 2026
+ *
+ * @brief  Lattices and graphs with precomputed neighbor tables.
+ *
+ * The neighbors of all sites are stored in compressed sparse row
+ * format: the neighbors of site x are neighbors[offsets[x]], ...,
+ * neighbors[offsets[x+1]-1].  Available are
+ * - the l-by-l torus with eight neighbors, in the order of the
+ *   stepping stone model (see stepping_stone.h);
+ * - the hexagonal l-by-l torus with six neighbors (axial
+ *   coordinates);
+ * - the cubic l-by-l-by-l torus with six neighbors;
+ * - arbitrary undirected graphs read from an edge list.
+ *
+ * The sites of the regular lattices can be numbered row by row or
+ * along the Morton (Z-order) curve, which keeps neighbors close in
+ * memory on large lattices.  Either way, grid_site() maps the row
+ * major index of a site to its number.
+ *
+ */
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <vector>
+#include <stdint.h>
+
+enum lattice_type {
+    LATTICE_TORUS,
+    LATTICE_HEXAGONAL,
+    LATTICE_CUBIC,
+    LATTICE_GRAPH
+};
+
+class Lattice {
+ public:
+    /**
+     * Build a regular lattice.
+     *
+     * @param type LATTICE_TORUS, LATTICE_HEXAGONAL or LATTICE_CUBIC.
+     * @param l the side length.
+     * @param morton number the sites along the Morton curve.
+     */
+    Lattice(lattice_type type, unsigned int l, bool morton=false);
+
+    /**
+     * Read a graph from an edge list.  Each line contains the
+     * numbers of two sites, starting from 0; lines starting with #
+     * are ignored.  Edges are undirected; self loops are dropped.
+     *
+     * @param fn the file name.
+     */
+    Lattice(const char * fn);
+
+    /// The number of sites.
+    unsigned long n_sites() const { return offsets.size() - 1; }
+
+    /// The number of neighbors of site x.
+    unsigned int degree(unsigned long x) const {
+        return offsets[x+1] - offsets[x];
+    }
+
+    /// Neighbor k of site x.
+    uint32_t neighbor(unsigned long x, unsigned int k) const {
+        return neighbors[offsets[x] + k];
+    }
+
+    /// True if all sites have the same number of neighbors.
+    bool is_regular() const { return regular; }
+
+    /// The type of the lattice.
+    lattice_type get_type() const { return type; }
+
+    /// The dimension; 0 for graphs.
+    unsigned int get_dim() const { return dim; }
+
+    /// The side length; 0 for graphs.
+    unsigned int get_side() const { return side; }
+
+    /// The number of the site with row major index r.
+    uint32_t grid_site(unsigned long r) const {
+        return grid.empty() ? r : grid[r];
+    }
+
+ private:
+    /// Fill offsets and neighbors from a neighbor function on row
+    /// major indices and renumber the sites.
+    void build(unsigned int deg, bool morton);
+    lattice_type type;
+    unsigned int dim;
+    unsigned int side;
+    bool regular;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> neighbors;
+    /// Row major index to site number; empty if they are equal.
+    std::vector<uint32_t> grid;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#include "lockstep.h"
+#include "tools.h"
+
+/// Rotate the words of x left by k bits.
+#define LS_ROTL(x, k) (((x) << (k)) | ((x) >> (32 - (k))))
+
+/// Next output of the xoshiro128** generators with states x[0..3].
+/// Vectors are passed by pointer to keep the ABI independent of the
+/// instruction set.
+static inline void xoshiro_next(ls_vec * x, ls_vec * result) {
+    ls_vec y = x[1] * 5;
+    *result = LS_ROTL(y, 7) * 9;
+    ls_vec t = x[1] << 9;
+    x[2] ^= x[0];
+    x[3] ^= x[1];
+    x[1] ^= x[2];
+    x[0] ^= x[3];
+    x[2] ^= t;
+    x[3] = LS_ROTL(x[3], 11);
+}
+
+/// SplitMix64, used to seed the generators.
+static uint64_t splitmix64(uint64_t & x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+Lockstep::Lockstep(const double * p, unsigned int n,
+                   unsigned long n_replicates, unsigned long seed):
+    n(n),
+    n_replicates(n_replicates),
+    n_blocks((n_replicates + LOCKSTEP_LANES - 1) / LOCKSTEP_LANES),
+    stop(n, 0),
+    counted(n, 0),
+    state(n_blocks),
+    active(n_blocks),
+    steps(n_blocks),
+    hits(n_blocks),
+    used(n_blocks),
+    rng(4 * n_blocks)
+{
+    if (n < 1 || n > 65536) out_error("The number of states has to be 1-65536.");
+    bits = 1;
+    while ((1u << bits) < n) bits++;
+    n_cols = 1u << bits;
+
+    // Alias tables (Vose's method).
+    threshold.assign((size_t) n * n_cols, 0);
+    alias.assign((size_t) n * n_cols, 0);
+    std::vector<double> w(n_cols);
+    std::vector<unsigned int> small, large;
+    for (unsigned int i = 0; i < n; i++) {
+        double sum = 0;
+        for (unsigned int j = 0; j < n; j++) {
+            if (p[i*n + j] < 0) out_error("Negative transition probability.");
+            sum += p[i*n + j];
+        }
+        if (sum <= 0) out_error("Row without transitions.");
+        small.clear();
+        large.clear();
+        for (unsigned int j = 0; j < n_cols; j++) {
+            w[j] = j < n ? p[i*n + j] / sum * n_cols : 0;
+            if (w[j] < 1) small.push_back(j);
+            else large.push_back(j);
+        }
+        uint32_t * th = &threshold[(size_t) i * n_cols];
+        uint32_t * al = &alias[(size_t) i * n_cols];
+        while (!small.empty() && !large.empty()) {
+            unsigned int s = small.back();
+            unsigned int l = large.back();
+            small.pop_back();
+            th[s] = (uint32_t) (w[s] * 4294967296.0);
+            al[s] = l;
+            w[l] -= 1 - w[s];
+            if (w[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // The rest has probability one, up to rounding.
+        for (unsigned int k = 0; k < large.size(); k++) {
+            th[large[k]] = 0xffffffff;
+            al[large[k]] = large[k];
+        }
+        for (unsigned int k = 0; k < small.size(); k++) {
+            th[small[k]] = 0xffffffff;
+            al[small[k]] = small[k];
+        }
+    }
+
+    uint64_t x = seed;
+    for (unsigned long b = 0; b < n_blocks; b++) {
+        for (unsigned int l = 0; l < LOCKSTEP_LANES; l++) {
+            unsigned long r = b * LOCKSTEP_LANES + l;
+            used[b][l] = r < n_replicates ? 0xffffffff : 0;
+            uint64_t z = splitmix64(x);
+            rng[4*b][l] = z;
+            rng[4*b + 1][l] = z >> 32;
+            z = splitmix64(x);
+            rng[4*b + 2][l] = z;
+            rng[4*b + 3][l] = z >> 32;
+        }
+    }
+    reset(0);
+}
+
+void Lockstep::reset(unsigned int s) {
+    if (s >= n) out_error("State out of range.");
+    for (unsigned long b = 0; b < n_blocks; b++) {
+        for (unsigned int l = 0; l < LOCKSTEP_LANES; l++) {
+            state[b][l] = s;
+            steps[b][l] = 0;
+            hits[b][l] = 0;
+        }
+        active[b] = used[b];
+    }
+}
+
+void Lockstep::set_stop(const std::vector<unsigned int> & states) {
+    stop.assign(n, 0);
+    for (unsigned int k = 0; k < states.size(); k++) {
+        if (states[k] >= n) out_error("State out of range.");
+        stop[states[k]] = 0xffffffff;
+    }
+}
+
+void Lockstep::set_count(const std::vector<unsigned int> & states) {
+    counted.assign(n, 0);
+    for (unsigned int k = 0; k < states.size(); k++) {
+        if (states[k] >= n) out_error("State out of range.");
+        counted[states[k]] = 0xffffffff;
+    }
+}
+
+bool Lockstep::step() {
+    unsigned int shift = 32 - bits;
+    ls_vec any = {};
+    for (unsigned long b = 0; b < n_blocks; b++) {
+        ls_vec act = active[b];
+        ls_vec u;
+        xoshiro_next(&rng[4*b], &u);
+        // Column from the top bits, threshold from the rest.
+        ls_vec j = u >> shift;
+        ls_vec f = u << bits;
+        ls_vec s = state[b];
+        ls_vec idx = s * n_cols + j;
+        ls_vec t, a;
+        for (unsigned int l = 0; l < LOCKSTEP_LANES; l++) {
+            t[l] = threshold[idx[l]];
+            a[l] = alias[idx[l]];
+        }
+        ls_vec m = (ls_vec) (f < t);
+        ls_vec next = (j & m) | (a & ~m);
+        next = (next & act) | (s & ~act);
+        ls_vec st, ct;
+        for (unsigned int l = 0; l < LOCKSTEP_LANES; l++) {
+            st[l] = stop[next[l]];
+            ct[l] = counted[next[l]];
+        }
+        state[b] = next;
+        steps[b] += act & 1;
+        hits[b] += act & ct & 1;
+        active[b] = act & ~st;
+        any |= active[b];
+    }
+    for (unsigned int l = 0; l < LOCKSTEP_LANES; l++)
+        if (any[l]) return true;
+    return false;
+}
+
+unsigned long Lockstep::run(unsigned long max_steps) {
+    unsigned long k = 0;
+    while (k < max_steps) {
+        k++;
+        if (!step()) break;
+    }
+    return k;
+}
+
+void Lockstep::run_occupancy(unsigned long n_steps,
+                             std::vector<unsigned long> & occupancy) {
+    occupancy.assign(n, 0);
+    for (unsigned long k = 0; k < n_steps; k++) {
+        step();
+        for (unsigned long r = 0; r < n_replicates; r++)
+            occupancy[get_state(r)]++;
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file   lockstep.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 22:18:05 2026
+ *
+ * @brief  Run many replicates of a small discrete Markov chain in
+ * lockstep.
+ *
+ * The replicates are kept in struct-of-arrays form and processed
+ * LOCKSTEP_LANES at a time in the lanes of GCC vector types, so that
+ * one step of all replicates is a sequence of vector operations
+ * without branches.
+ *
+ * Each row of the transition probability matrix is turned into an
+ * alias table (Walker, 1977) that is padded with zero probabilities
+ * to a power of two columns.  A single 32 bit random number per
+ * replicate and step then suffices: the top bits select the column j
+ * and the remaining bits are compared against the threshold of the
+ * column, which gives either j or its alias.  The random numbers are
+ * drawn with one xoshiro128** generator per lane.  The table lookups
+ * are done lane by lane (gather).
+ *
+ * Exit conditions are handled with masks.  A replicate is active
+ * until it enters one of the stop states; then, it keeps its state
+ * and its counters.  For each replicate, the number of steps and the
+ * number of visits to the counted states are recorded.
+ *
+ */
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <vector>
+#include <stdint.h>
+
+#define LOCKSTEP_LANES 8
+
+typedef uint32_t ls_vec __attribute__ ((vector_size (LOCKSTEP_LANES * sizeof (uint32_t))));
+
+class Lockstep {
+ public:
+    /**
+     * Build the alias tables and seed the generators.
+     *
+     * @param p the transition probability matrix, row by row; the rows
+     * need not be normalized.
+     * @param n the number of states.
+     * @param n_replicates the number of replicates.
+     * @param seed the seed.
+     */
+    Lockstep(const double * p, unsigned int n, unsigned long n_replicates,
+             unsigned long seed=1);
+
+    /**
+     * Put all replicates into a state, activate them and set the
+     * counters to zero.
+     *
+     * @param s the state.
+     */
+    void reset(unsigned int s);
+
+    /**
+     * Set the stop states; active replicates that enter one of them
+     * become inactive.  By default, there are none.
+     *
+     * @param states the stop states.
+     */
+    void set_stop(const std::vector<unsigned int> & states);
+
+    /**
+     * Set the states whose visits are counted.
+     *
+     * @param states the counted states.
+     */
+    void set_count(const std::vector<unsigned int> & states);
+
+    /**
+     * Perform one step of all active replicates.
+     *
+     * @return false if no replicate is active anymore.
+     */
+    bool step();
+
+    /**
+     * Perform steps until no replicate is active anymore.
+     *
+     * @param max_steps the maximum number of steps.
+     *
+     * @return the number of steps performed.
+     */
+    unsigned long run(unsigned long max_steps);
+
+    /**
+     * Perform steps and count the time that the replicates spend in
+     * each state (after each step).
+     *
+     * @param n_steps the number of steps.
+     * @param occupancy OUT; the number of replicates and steps in each
+     * state; length n.
+     */
+    void run_occupancy(unsigned long n_steps,
+                       std::vector<unsigned long> & occupancy);
+
+    /// The number of replicates.
+    unsigned long get_n_replicates() const { return n_replicates; }
+
+    /// The state of replicate r.
+    unsigned int get_state(unsigned long r) const {
+        return state[r / LOCKSTEP_LANES][r % LOCKSTEP_LANES];
+    }
+
+    /// The number of steps of replicate r while it was active.
+    unsigned long get_steps(unsigned long r) const {
+        return steps[r / LOCKSTEP_LANES][r % LOCKSTEP_LANES];
+    }
+
+    /// The number of visits of replicate r to the counted states.
+    unsigned long get_hits(unsigned long r) const {
+        return hits[r / LOCKSTEP_LANES][r % LOCKSTEP_LANES];
+    }
+
+    /// True if replicate r is active.
+    bool is_active(unsigned long r) const {
+        return active[r / LOCKSTEP_LANES][r % LOCKSTEP_LANES] != 0;
+    }
+
+ private:
+    /// Number of states.
+    unsigned int n;
+    /// Number of columns of the alias tables, 2^bits.
+    unsigned int bits;
+    unsigned int n_cols;
+    unsigned long n_replicates;
+    /// Number of vectors of lanes.
+    unsigned long n_blocks;
+    /// Alias tables, row by row: threshold (probability times 2^32)
+    /// and alias of each column.
+    std::vector<uint32_t> threshold;
+    std::vector<uint32_t> alias;
+    /// Masks of the stop and the counted states (all bits set or
+    /// zero).
+    std::vector<uint32_t> stop;
+    std::vector<uint32_t> counted;
+    /// States, activity masks and counters of the replicates.
+    std::vector<ls_vec> state;
+    std::vector<ls_vec> active;
+    std::vector<ls_vec> steps;
+    std::vector<ls_vec> hits;
+    /// Mask of the lanes that hold replicates.
+    std::vector<ls_vec> used;
+    /// Generator states, four words per lane.
+    std::vector<ls_vec> rng;
+};
+
+#endif
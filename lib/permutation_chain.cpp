@@ -0,0 +1,185 @@
+#include "permutation_chain.h"
+#include "barrier.h"
+#include "tools.h"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+/// Factorials up to 20!.
+static const unsigned long fac_table[21] = {
+    1ul, 1ul, 2ul, 6ul, 24ul, 120ul, 720ul, 5040ul, 40320ul, 362880ul,
+    3628800ul, 39916800ul, 479001600ul, 6227020800ul, 87178291200ul,
+    1307674368000ul, 20922789888000ul, 355687428096000ul,
+    6402373705728000ul, 121645100408832000ul, 2432902008176640000ul};
+
+unsigned long factorial(unsigned int n) {
+    if (n > 20) out_error("n! does not fit into 64 bits for n > 20.");
+    return fac_table[n];
+}
+
+PermutationChain::PermutationChain(unsigned int n, permutation_move move):
+    n(n),
+    move(move),
+    order(n),
+    tmp(n)
+{
+    if (n < 1 || n > 20) out_error("The number of items has to be 1-20.");
+    reset();
+}
+
+void PermutationChain::reset() {
+    for (unsigned int i = 0; i < n; i++) order[i] = i;
+    misplaced = 0;
+}
+
+void PermutationChain::riffle(RanGen & rg) {
+    unsigned long bits = rg.pick_uniform_int(1ul << n);
+    unsigned int k = 0;
+    for (unsigned int i = 0; i < n; i++)
+        if (!(bits >> i & 1)) tmp[k++] = order[i];
+    for (unsigned int i = 0; i < n; i++)
+        if (bits >> i & 1) tmp[k++] = order[i];
+    order.swap(tmp);
+    misplaced = 0;
+    for (unsigned int i = 0; i < n; i++) misplaced += order[i] != i;
+}
+
+unsigned long PermutationChain::rank() const {
+    uint32_t used = 0;
+    unsigned long r = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int x = order[i];
+        unsigned int d = x - __builtin_popcount(used & ((1u << x) - 1));
+        r += d * fac_table[n - 1 - i];
+        used |= 1u << x;
+    }
+    return r;
+}
+
+void PermutationChain::run(unsigned long n_steps, RanGen & rg,
+                           std::vector<uint32_t> & hist) {
+    if (n > 12) out_error("Histograms only for up to 12 items.");
+    if (hist.size() != fac_table[n]) hist.assign(fac_table[n], 0);
+    for (unsigned long s = 0; s < n_steps; s++) {
+        step(rg);
+        hist[rank()]++;
+    }
+}
+
+/**
+ * Data shared by the threads of permutation_chain_tv().
+ */
+struct permutation_tv_run {
+    unsigned int n;
+    permutation_move move;
+    unsigned long n_steps;
+    unsigned long n_reps;
+    unsigned int n_threads;
+    /// Replicates per state in the uniform distribution.
+    double m;
+    /// Number of replicates in each state.
+    std::vector<std::atomic<uint32_t> > * hist;
+    /// Changes of the sum of |count - m| and of the number of items
+    /// out of place, of each thread in the current step.
+    std::vector<double> ds;
+    std::vector<long> dmis;
+    Barrier * barrier;
+    /// Random number generators of the threads; they are initialized
+    /// before the threads start, because the constructor of RanGen
+    /// sets global GSL defaults.
+    std::vector<RanGen*> rg;
+    std::vector<double> * tv;
+    std::vector<double> * misplaced;
+};
+
+void permutation_chain_tv_thread(permutation_tv_run * pr, unsigned int tid) {
+    RanGen & rg = *pr->rg[tid];
+    unsigned long share = pr->n_reps / pr->n_threads;
+    if (tid < pr->n_reps % pr->n_threads) share++;
+    std::vector<PermutationChain> reps(share,
+                                       PermutationChain(pr->n, pr->move));
+    std::vector<unsigned long> ranks(share, 0);
+    std::vector<std::atomic<uint32_t> > & hist = *pr->hist;
+    double m = pr->m;
+    double s = 0;
+    long s_mis = 0;
+
+    for (unsigned long t = 1; t <= pr->n_steps; t++) {
+        double ds = 0;
+        long dmis = 0;
+        for (unsigned long r = 0; r < share; r++) {
+            unsigned int mis = reps[r].get_misplaced();
+            reps[r].step(rg);
+            dmis += (long) reps[r].get_misplaced() - mis;
+            unsigned long x = reps[r].rank();
+            if (x == ranks[r]) continue;
+            double c = hist[ranks[r]].fetch_sub(1);
+            ds += std::fabs(c - 1 - m) - std::fabs(c - m);
+            c = hist[x].fetch_add(1);
+            ds += std::fabs(c + 1 - m) - std::fabs(c - m);
+            ranks[r] = x;
+        }
+        pr->ds[tid] = ds;
+        pr->dmis[tid] = dmis;
+        pr->barrier->wait();
+        if (tid == 0) {
+            // The sum starts at its value with all replicates at the
+            // identity.
+            if (t == 1) {
+                double f = hist.size();
+                s = std::fabs(pr->n_reps - m) + (f - 1) * m;
+            }
+            for (unsigned int k = 0; k < pr->n_threads; k++) {
+                s += pr->ds[k];
+                s_mis += pr->dmis[k];
+            }
+            (*pr->tv)[t] = s / (2.0 * pr->n_reps);
+            (*pr->misplaced)[t] = (double) s_mis / pr->n_reps;
+        }
+        pr->barrier->wait();
+    }
+}
+
+void permutation_chain_tv(unsigned int n, permutation_move move,
+                          unsigned long n_steps, unsigned long n_reps,
+                          unsigned int n_threads, unsigned long seed,
+                          std::vector<double> & tv,
+                          std::vector<double> & misplaced) {
+    if (n < 1 || n > 12) out_error("The number of items has to be 1-12.");
+    if (n_reps == 0 || n_reps >= 0xffffffff)
+        out_error("The number of replicates has to be 1-2^32.");
+    if (n_threads == 0) n_threads = 1;
+    unsigned long n_states = factorial(n);
+    std::vector<std::atomic<uint32_t> > hist(n_states);
+    for (unsigned long x = 0; x < n_states; x++) hist[x] = 0;
+    hist[0] = n_reps;
+
+    permutation_tv_run pr;
+    pr.n = n;
+    pr.move = move;
+    pr.n_steps = n_steps;
+    pr.n_reps = n_reps;
+    pr.n_threads = n_threads;
+    pr.m = (double) n_reps / n_states;
+    pr.hist = &hist;
+    pr.ds.assign(n_threads, 0);
+    pr.dmis.assign(n_threads, 0);
+    Barrier barrier(n_threads);
+    pr.barrier = &barrier;
+    tv.assign(n_steps + 1, 0);
+    misplaced.assign(n_steps + 1, 0);
+    tv[0] = 1.0 - 1.0 / n_states;
+    pr.tv = &tv;
+    pr.misplaced = &misplaced;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        pr.rg.push_back(new RanGen());
+        pr.rg[t]->set_seed(seed + t);
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++)
+        threads.push_back(std::thread(permutation_chain_tv_thread, &pr, t));
+    for (unsigned int t = 0; t < n_threads; t++) threads[t].join();
+    for (unsigned int t = 0; t < n_threads; t++) delete pr.rg[t];
+}
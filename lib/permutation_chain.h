@@ -0,0 +1,139 @@
+/**
+ * @file   permutation_chain.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 23:26:10 2026
+ *
+ * @brief  Markov chains on the permutations of n items (card
+ * shuffling, bookshelf).
+ *
+ * Moves:
+ * - MOVE_SWAP_FRONT: a random item is swapped with the first one (the
+ *   bookshelf of Norris, exercise 1.8.4);
+ * - MOVE_TRANSPOSITION: two random positions, possibly equal, are
+ *   swapped;
+ * - MOVE_RIFFLE: inverse Gilbert-Shannon-Reeds riffle shuffle; each
+ *   item gets a random bit and the items with bit 0 are moved to the
+ *   front, keeping their order.  From the identity, the distance to
+ *   the uniform distribution after t inverse riffles equals the one
+ *   after t riffles.
+ *
+ * Permutations are ranked by their Lehmer code in O(n): the digit of
+ * position i is the number of unused items smaller than the item at
+ * i, counted with a bit mask.  The identity has rank 0.  With the
+ * ranks, the visits to all n! states are counted in a histogram, for
+ * n up to 12.  The number of items out of place (the Hamming distance
+ * to the identity) is kept up to date with each move.
+ *
+ * permutation_chain_tv() runs many replicates from the identity on
+ * several threads and follows the distribution over the n! states in
+ * time.  The replicates of all threads share one histogram with
+ * atomic counters; since each change of a counter is seen with its
+ * old value, the sum of |count - replicates/n!| over all states, and
+ * hence the total variation distance to the uniform distribution, is
+ * updated exactly with each move.  With R replicates, the estimate
+ * has a noise floor of roughly sqrt(n!/(2 pi R)).
+ *
+ */
+
+#ifndef PERMUTATION_CHAIN_H
+#define PERMUTATION_CHAIN_H
+
+#include <vector>
+#include <stdint.h>
+#include "ran_generator.h"
+
+enum permutation_move {
+    MOVE_SWAP_FRONT,
+    MOVE_TRANSPOSITION,
+    MOVE_RIFFLE
+};
+
+/**
+ * n factorial; only for n up to 20, where it fits into 64 bits.
+ *
+ */
+unsigned long factorial(unsigned int n);
+
+class PermutationChain {
+ public:
+    /**
+     * Initialize with the identity.
+     *
+     * @param n the number of items, up to 20.
+     * @param move the move.
+     */
+    PermutationChain(unsigned int n, permutation_move move);
+
+    /// Go back to the identity.
+    void reset();
+
+    /**
+     * Perform one move.
+     *
+     * @param rg random number generator.
+     */
+    void step(RanGen & rg) {
+        if (move == MOVE_RIFFLE) riffle(rg);
+        else if (move == MOVE_SWAP_FRONT) swap(0, rg.pick_uniform_int(n));
+        else swap(rg.pick_uniform_int(n), rg.pick_uniform_int(n));
+    }
+
+    /**
+     * Perform several moves and count the visits to each state (after
+     * each move).
+     *
+     * @param n_steps the number of moves.
+     * @param rg random number generator.
+     * @param hist IN/OUT; the counts are added, length n!; n has to be
+     * at most 12.
+     */
+    void run(unsigned long n_steps, RanGen & rg,
+             std::vector<uint32_t> & hist);
+
+    /// The Lehmer rank of the permutation.
+    unsigned long rank() const;
+
+    /// The number of items out of place.
+    unsigned int get_misplaced() const { return misplaced; }
+
+    /// The items, position by position.
+    const std::vector<unsigned char> & get_order() const { return order; }
+
+ private:
+    /// Swap the items at positions a and b.
+    void swap(unsigned int a, unsigned int b) {
+        misplaced -= (order[a] != a) + (order[b] != b);
+        unsigned char tmp = order[a];
+        order[a] = order[b];
+        order[b] = tmp;
+        misplaced += (order[a] != a) + (order[b] != b);
+    }
+    /// Inverse riffle shuffle.
+    void riffle(RanGen & rg);
+    unsigned int n;
+    permutation_move move;
+    std::vector<unsigned char> order;
+    std::vector<unsigned char> tmp;
+    unsigned int misplaced;
+};
+
+/**
+ * Total variation distance to the uniform distribution in time, from
+ * replicates started at the identity.
+ *
+ * @param n the number of items, up to 12.
+ * @param move the move.
+ * @param n_steps the number of moves.
+ * @param n_reps the number of replicates.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param tv OUT; the distance after 0, ..., n_steps moves.
+ * @param misplaced OUT; the mean number of items out of place.
+ */
+void permutation_chain_tv(unsigned int n, permutation_move move,
+                          unsigned long n_steps, unsigned long n_reps,
+                          unsigned int n_threads, unsigned long seed,
+                          std::vector<double> & tv,
+                          std::vector<double> & misplaced);
+
+#endif
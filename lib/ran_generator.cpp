@@ -33,6 +33,36 @@ double RanGen::pick_uniform()
     return gsl_rng_uniform (r);
 }
 
+unsigned int RanGen::pick_binomial(double p, unsigned int n)
+{
+    return gsl_ran_binomial (r, p, n);
+}
+
+double RanGen::pick_gaussian(double sigma)
+{
+    return gsl_ran_gaussian_ziggurat (r, sigma);
+}
+
+unsigned int RanGen::pick_poisson(double mean)
+{
+    return gsl_ran_poisson (r, mean);
+}
+
+unsigned int RanGen::pick_geometric(double p)
+{
+    return gsl_ran_geometric (r, p);
+}
+
+unsigned long RanGen::pick_uniform_int(unsigned long n)
+{
+    return gsl_rng_uniform_int (r, n);
+}
+
+size_t RanGen::pick_discrete(const gsl_ran_discrete_t * g)
+{
+    return gsl_ran_discrete (r, g);
+}
+
 int RanGen::vector_weighted_pick (gsl_vector * v, int l)
 {
     double sum = 0.0;
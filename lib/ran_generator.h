@@ -63,6 +63,62 @@ class RanGen
      */
     double pick_uniform ();
 
+    /** 
+     * Simulate a binomially distributed random variable.
+     * 
+     * @param p the success probability.
+     * @param n the number of trials.
+     * 
+     * @return the number of successes.
+     */
+    unsigned int pick_binomial (double p, unsigned int n);
+
+    /** 
+     * Simulate a normally distributed random variable with mean 0.
+     * 
+     * @param sigma the standard deviation.
+     * 
+     * @return the picked value.
+     */
+    double pick_gaussian (double sigma);
+
+    /** 
+     * Simulate a Poisson distributed random variable.
+     * 
+     * @param mean the mean.
+     * 
+     * @return the picked value.
+     */
+    unsigned int pick_poisson (double mean);
+
+    /** 
+     * Simulate a geometric random variable: the number of trials up
+     * to and including the first success.
+     * 
+     * @param p the probability of success.
+     * 
+     * @return the picked value.
+     */
+    unsigned int pick_geometric (double p);
+
+    /** 
+     * Simulate a uniformly distributed integer between 0 and n-1.
+     * 
+     * @param n the number of values.
+     * 
+     * @return the picked value.
+     */
+    unsigned long pick_uniform_int (unsigned long n);
+
+    /** 
+     * Pick a value from a general discrete distribution.
+     * 
+     * @param g the lookup table; see gsl_ran_discrete_preproc().
+     * 
+     * @return the picked index.
+     */
+    size_t pick_discrete (const gsl_ran_discrete_t * g);
+
     /** 
      * Randomly pick an element out of a vector according to its value.
      *
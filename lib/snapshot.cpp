@@ -0,0 +1,87 @@
+#include "snapshot.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <stdint.h>
+
+SnapshotWriter::SnapshotWriter(const char * fn, unsigned long n_sites,
+                               unsigned int n_colors, unsigned int side,
+                               unsigned int layout,
+                               const std::vector<uint32_t> & order,
+                               unsigned int max_queue):
+    out(fn, std::ios::binary),
+    n_sites(n_sites),
+    order(order),
+    max_queue(max_queue > 0 ? max_queue : 1),
+    done(false)
+{
+    if (!out) out_error("Could not open the snapshot file.");
+    if (!order.empty() && order.size() != n_sites)
+        out_error("Wrong number of sites in the order.");
+    if (n_colors <= 2) bits = 1;
+    else if (n_colors <= 4) bits = 2;
+    else if (n_colors <= 16) bits = 4;
+    else bits = 8;
+    uint64_t n = n_sites;
+    uint32_t s = side;
+    uint32_t y = layout;
+    uint32_t b = bits;
+    out.write("SSFRAME2", 8);
+    out.write((const char *) &n, sizeof(n));
+    out.write((const char *) &s, sizeof(s));
+    out.write((const char *) &y, sizeof(y));
+    out.write((const char *) &b, sizeof(b));
+    if (!out) out_error("Could not write to the snapshot file.");
+    writer = std::thread(&SnapshotWriter::write_frames, this);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        done = true;
+    }
+    cv.notify_all();
+    writer.join();
+    out.close();
+    if (!out) out_error("Could not write to the snapshot file.");
+}
+
+void SnapshotWriter::push(unsigned long step, double time,
+                          const std::vector<unsigned char> & field) {
+    if (field.size() != n_sites) out_error("Wrong number of sites.");
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [this] { return queue.size() < max_queue; });
+    queue.push_back(frame());
+    queue.back().step = step;
+    queue.back().time = time;
+    queue.back().field = field;
+    cv.notify_all();
+}
+
+void SnapshotWriter::write_frames() {
+    std::vector<unsigned char> packed((n_sites * bits + 7) / 8);
+    while (true) {
+        frame f;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [this] { return done || !queue.empty(); });
+            if (queue.empty()) return;
+            f.step = queue.front().step;
+            f.time = queue.front().time;
+            f.field.swap(queue.front().field);
+            queue.pop_front();
+        }
+        cv.notify_all();
+        std::fill(packed.begin(), packed.end(), 0);
+        for (unsigned long r = 0; r < n_sites; r++) {
+            unsigned long pos = r * bits;
+            unsigned long x = order.empty() ? r : order[r];
+            packed[pos / 8] |= f.field[x] << (pos % 8);
+        }
+        uint64_t step = f.step;
+        out.write((const char *) &step, sizeof(step));
+        out.write((const char *) &f.time, sizeof(f.time));
+        out.write((const char *) &packed[0], packed.size());
+        if (!out) out_error("Could not write to the snapshot file.");
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * @file   snapshot.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 21:47:12 2026
+ *
+ * @brief  Write snapshots of a lattice to a binary file.
+ *
+ * The colors of the sites are packed into 1, 2, 4 or 8 bits, depending
+ * on the number of colors, and written by a background thread, so
+ * that the simulation only pays for copying the field.  At most a
+ * few frames wait in the queue; if it is full, push() blocks.
+ *
+ * The sites of regular lattices are written in row major order, also
+ * if they are numbered along the Morton curve in memory (see
+ * lattice.h); the sites of graphs in the order of their numbers.
+ *
+ * File format (native byte order):
+ * - header: the 8 bytes "SSFRAME2", the number of sites (uint64), the
+ *   side length of regular lattices or 0 (uint32), the layout (uint32;
+ *   the value of lattice_type: 0 square torus, 1 hexagonal torus in
+ *   axial coordinates, 2 cubic torus, 3 graph) and the number of bits
+ *   per site (uint32);
+ * - frames: the step (uint64), the time (double) and the packed
+ *   colors, (n_sites*bits+7)/8 bytes; the r-th site is stored in bits
+ *   (r*bits) % 8 and up of byte r*bits/8.
+ *
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+class SnapshotWriter {
+ public:
+    /**
+     * Open the file and write the header.
+     *
+     * @param fn the file name.
+     * @param n_sites the number of sites.
+     * @param n_colors the number of colors.
+     * @param side the side length of a regular lattice, or 0.
+     * @param layout the layout of the sites (see above).
+     * @param order the site number of the r-th site of the file; empty
+     * if they are equal.
+     * @param max_queue the number of frames that may wait.
+     */
+    SnapshotWriter(const char * fn, unsigned long n_sites,
+                   unsigned int n_colors, unsigned int side=0,
+                   unsigned int layout=0,
+                   const std::vector<uint32_t> & order
+                   = std::vector<uint32_t>(),
+                   unsigned int max_queue=4);
+
+    /// Write the remaining frames and close the file; the program
+    /// exits with an error if writing failed.
+    ~SnapshotWriter();
+
+    /**
+     * Queue a frame.
+     *
+     * @param step the step.
+     * @param time the time.
+     * @param field the colors of the sites.
+     */
+    void push(unsigned long step, double time,
+              const std::vector<unsigned char> & field);
+
+ private:
+    struct frame {
+        unsigned long step;
+        double time;
+        std::vector<unsigned char> field;
+    };
+    /// Thread that packs and writes the frames.
+    void write_frames();
+    std::ofstream out;
+    unsigned long n_sites;
+    unsigned int bits;
+    /// Site number of the r-th site of the file; empty for identity.
+    std::vector<uint32_t> order;
+    unsigned int max_queue;
+    std::deque<frame> queue;
+    bool done;
+    std::mutex m;
+    std::condition_variable cv;
+    std::thread writer;
+};
+
+#endif
@@ -0,0 +1,500 @@
+#include "stepping_stone.h"
+#include "barrier.h"
+#include "tools.h"
+
+#include <cmath>
+#include <thread>
+#include <unordered_map>
+
+const int torus_di[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+const int torus_dj[8] = {-1, -1, -1, 0, 1, 1, 1, 0};
+
+const uint32_t SteppingStone::NO_PAIR;
+
+/// SplitMix64, used to derive seeds.
+static uint64_t splitmix64(uint64_t & x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+SteppingStone::SteppingStone(unsigned int l, unsigned int k):
+    lat(NULL),
+    l(l),
+    n_sites((unsigned long) l * l),
+    k(k),
+    clusters(false),
+    n_clusters(0),
+    largest(0),
+    field(n_sites),
+    kmc_valid(false)
+{
+    if (l < 2) out_error("The side length has to be at least two.");
+    if (k < 1 || k > 255) out_error("The number of colors has to be 1-255.");
+    for (size_t i = 0; i < field.size(); i++) field[i] = i % k;
+    recount();
+    rg = new RanGen();
+}
+
+SteppingStone::SteppingStone(const Lattice & lat, unsigned int k):
+    lat(&lat),
+    l(lat.get_dim() == 2 ? lat.get_side() : 0),
+    n_sites(lat.n_sites()),
+    k(k),
+    clusters(false),
+    n_clusters(0),
+    largest(0),
+    field(n_sites),
+    kmc_valid(false)
+{
+    if (k < 1 || k > 255) out_error("The number of colors has to be 1-255.");
+    for (size_t i = 0; i < field.size(); i++) field[lat.grid_site(i)] = i % k;
+    recount();
+    rg = new RanGen();
+}
+
+SteppingStone::~SteppingStone() {
+    delete rg;
+}
+
+void SteppingStone::recount() {
+    counts.assign(k, 0);
+    interface = 0;
+    n_edges = 0;
+    for (unsigned long x = 0; x < n_sites; x++) {
+        counts[field[x]]++;
+        for (unsigned int d = 0; d < degree(x); d++) {
+            n_edges++;
+            if (field[neighbor(x, d)] != field[x]) interface++;
+        }
+    }
+    // Each edge has been seen from both ends.
+    n_edges /= 2;
+    interface /= 2;
+}
+
+void SteppingStone::track_clusters(unsigned long rebuild) {
+    this->rebuild = rebuild > 0 ? rebuild : n_sites;
+    if (n_sites + this->rebuild >= 0xffffffff)
+        out_error("Lattice too large to track clusters.");
+    clusters = true;
+    rebuild_clusters();
+}
+
+void SteppingStone::resize_cluster(uint32_t u, long ds) {
+    unsigned long old = uf_size[u];
+    unsigned long now = old + ds;
+    if (old > 0) size_hist[old]--;
+    else n_clusters++;
+    if (now > 0) size_hist[now]++;
+    else n_clusters--;
+    uf_size[u] = now;
+    if (now > largest) largest = now;
+    while (largest > 0 && size_hist[largest] == 0) largest--;
+}
+
+void SteppingStone::join(uint32_t u, uint32_t v) {
+    u = find(u);
+    v = find(v);
+    if (u == v) return;
+    if (uf_size[u] < uf_size[v]) std::swap(u, v);
+    long sv = uf_size[v];
+    resize_cluster(v, -sv);
+    resize_cluster(u, sv);
+    uf_parent[v] = u;
+}
+
+void SteppingStone::rebuild_clusters() {
+    uf_node.resize(n_sites);
+    uf_parent.resize(n_sites);
+    uf_size.assign(n_sites, 1);
+    size_hist.assign(n_sites + 1, 0);
+    size_hist[1] = n_sites;
+    n_clusters = n_sites;
+    largest = n_sites > 0 ? 1 : 0;
+    n_changes = 0;
+    for (unsigned long x = 0; x < n_sites; x++) uf_node[x] = uf_parent[x] = x;
+    for (unsigned long x = 0; x < n_sites; x++)
+        for (unsigned int d = 0; d < degree(x); d++) {
+            unsigned long y = neighbor(x, d);
+            if (field[x] == field[y]) join(x, y);
+        }
+}
+
+void SteppingStone::recolor(unsigned long x, unsigned char c) {
+    long dinterface = 0;
+    recolor(x, c, &counts[0], dinterface);
+    interface += dinterface;
+    if (!clusters) return;
+    if (++n_changes > rebuild) {
+        rebuild_clusters();
+        return;
+    }
+    // Leave the old cluster, which may have been split.
+    resize_cluster(find(uf_node[x]), -1);
+    uint32_t u = uf_parent.size();
+    uf_parent.push_back(u);
+    uf_size.push_back(0);
+    uf_node[x] = u;
+    resize_cluster(u, 1);
+    for (unsigned int d = 0; d < degree(x); d++) {
+        unsigned long y = neighbor(x, d);
+        if (field[y] == c) join(u, uf_node[y]);
+    }
+}
+
+void SteppingStone::jump() {
+    kmc_valid = false;
+    unsigned long pick = rg->pick_uniform_int(n_sites);
+    unsigned int d = rg->pick_uniform_int(degree(pick));
+    copy_neighbor(pick, d);
+}
+
+void SteppingStone::run(unsigned long n_steps) {
+    for (unsigned long s = 0; s < n_steps; s++) jump();
+}
+
+void SteppingStone::update_pair(unsigned long p) {
+    unsigned long x = p / kmc_degree;
+    bool is_active = field[x] != field[neighbor(x, p % kmc_degree)];
+    if (is_active && active_pos[p] == NO_PAIR) {
+        active_pos[p] = active.size();
+        active.push_back(p);
+    }
+    else if (!is_active && active_pos[p] != NO_PAIR) {
+        uint32_t last = active.back();
+        active[active_pos[p]] = last;
+        active_pos[last] = active_pos[p];
+        active.pop_back();
+        active_pos[p] = NO_PAIR;
+    }
+}
+
+unsigned long SteppingStone::run_kmc(unsigned long n_steps) {
+    if (lat && !lat->is_regular())
+        out_error("run_kmc() needs a lattice with constant degree.");
+    if (!kmc_valid) {
+        kmc_degree = degree(0);
+        unsigned long n_pairs = kmc_degree * n_sites;
+        if (n_pairs >= NO_PAIR) out_error("Lattice too large for run_kmc().");
+        active.clear();
+        active_pos.assign(n_pairs, NO_PAIR);
+        for (unsigned long p = 0; p < n_pairs; p++) update_pair(p);
+        kmc_valid = true;
+    }
+    unsigned int deg = kmc_degree;
+    unsigned long n_pairs = deg * n_sites;
+
+    unsigned long steps = 0;
+    while (!active.empty()) {
+        // Skip the steps that do not change the torus.
+        unsigned long skip = rg->pick_geometric((double) active.size()
+                                                / n_pairs);
+        if (steps + skip > n_steps) {
+            steps = n_steps;
+            break;
+        }
+        steps += skip;
+        uint32_t p = active[rg->pick_uniform_int(active.size())];
+        unsigned long x = p / deg;
+        copy_neighbor(x, p % deg);
+        // Pairs with x as receiver, and with x as neighbor.
+        for (unsigned int d = 0; d < deg; d++) {
+            update_pair(deg * x + d);
+            unsigned long y = neighbor(x, d);
+            for (unsigned int e = 0; e < deg; e++)
+                if (neighbor(y, e) == x) update_pair(deg * y + e);
+        }
+    }
+    return steps;
+}
+
+void SteppingStone::print(std::ostream & out) const {
+    if (l == 0) out_error("Only two dimensional lattices can be printed.");
+    for (unsigned int i = 0; i < l; i++) {
+        for (unsigned int j = 0; j < l; j++) {
+            unsigned char c = field[site(i, j)];
+            if (c == 1) out << "+";
+            else if (c == 0) out << " ";
+            else if (c < k) out << (char) ('a' + (c - 2) % 26);
+            else out_error("Unknown field value.");
+        }
+        out << std::endl;
+    }
+}
+
+/**
+ * Data shared by the threads of run_tiled().
+ */
+struct tiled_run {
+    /// Number of tiles per dimension (even).
+    unsigned int n_tiles;
+    /// Tile boundaries; tile k spans [bound[k], bound[k+1]).
+    std::vector<unsigned int> bound;
+    /// Random number generators of the tiles.
+    std::vector<RanGen *> tile_rg;
+    /// Number and length of the windows.
+    unsigned long n_windows;
+    double dt;
+    /// Order of the four tile classes in each window; 4 entries per
+    /// window.
+    std::vector<unsigned char> order;
+    unsigned int n_threads;
+    Barrier * barrier;
+    /// Changes of the color counts and the interface of each thread.
+    std::vector<std::vector<long> > dcounts;
+    std::vector<long> dinterface;
+};
+
+void stepping_stone_tiles(SteppingStone * ss, unsigned int tid,
+                          void * shared) {
+    tiled_run * tr = (tiled_run *) shared;
+    unsigned int nt = tr->n_tiles;
+    unsigned int half = nt / 2;
+    long * dcounts = &tr->dcounts[tid][0];
+    long & dinterface = tr->dinterface[tid];
+
+    for (unsigned long w = 0; w < tr->n_windows; w++) {
+        const unsigned char * order = &tr->order[4 * w];
+        for (unsigned int c = 0; c < 4; c++) {
+            unsigned int ci = order[c] / 2;
+            unsigned int cj = order[c] % 2;
+            // Tiles of class (ci, cj), distributed over the threads.
+            for (unsigned int k = tid; k < half * half; k += tr->n_threads) {
+                unsigned int ti = 2 * (k / half) + ci;
+                unsigned int tj = 2 * (k % half) + cj;
+                RanGen & rg = *tr->tile_rg[ti * nt + tj];
+                unsigned int i0 = tr->bound[ti];
+                unsigned int j0 = tr->bound[tj];
+                unsigned int h = tr->bound[ti+1] - i0;
+                unsigned int b = tr->bound[tj+1] - j0;
+                unsigned long area = (unsigned long) h * b;
+                unsigned int n_steps = rg.pick_poisson(area * tr->dt);
+                for (unsigned int s = 0; s < n_steps; s++) {
+                    unsigned long pick = rg.pick_uniform_int(area);
+                    unsigned long x = ss->site(i0 + pick / b, j0 + pick % b);
+                    unsigned int d = rg.pick_uniform_int(ss->degree(x));
+                    unsigned char c = ss->field[ss->neighbor(x, d)];
+                    if (c != ss->field[x])
+                        ss->recolor(x, c, dcounts, dinterface);
+                }
+            }
+            tr->barrier->wait();
+        }
+    }
+}
+
+void SteppingStone::run_tiled(double time, unsigned int n_threads,
+                              unsigned long seed, double window,
+                              unsigned int tile) {
+    if (l == 0) out_error("run_tiled() needs a two dimensional lattice.");
+    if (n_threads == 0) n_threads = 1;
+    if (tile == 0) tile = 1;
+    if (window <= 0) out_error("The window length has to be positive.");
+    tiled_run tr;
+    unsigned int half = (unsigned int) std::floor(l / (2.0 * tile) + 0.5);
+    if (half < 1) half = 1;
+    if (2 * half > l) half = l / 2;
+    tr.n_tiles = 2 * half;
+    for (unsigned int k = 0; k <= tr.n_tiles; k++)
+        tr.bound.push_back((unsigned long) k * l / tr.n_tiles);
+    for (unsigned int k = 0; k < tr.n_tiles * tr.n_tiles; k++) {
+        tr.tile_rg.push_back(new RanGen());
+        tr.tile_rg[k]->set_seed(seed + k);
+    }
+    tr.n_windows = (unsigned long) std::ceil(time / window);
+    tr.dt = tr.n_windows > 0 ? time / tr.n_windows : 0;
+    // The order of the classes is drawn here, because the constructor
+    // of RanGen sets global GSL defaults.  Its seed is derived from
+    // the seed, so that it does not repeat the stream of a tile.
+    RanGen order_rg;
+    uint64_t order_seed = seed;
+    order_rg.set_seed(splitmix64(order_seed));
+    unsigned char order[4] = {0, 1, 2, 3};
+    for (unsigned long w = 0; w < tr.n_windows; w++) {
+        for (unsigned int k = 3; k > 0; k--)
+            std::swap(order[k], order[order_rg.pick_uniform_int(k+1)]);
+        tr.order.insert(tr.order.end(), order, order + 4);
+    }
+    tr.n_threads = n_threads;
+    Barrier barrier(n_threads);
+    tr.barrier = &barrier;
+    tr.dcounts.assign(n_threads, std::vector<long>(k, 0));
+    tr.dinterface.assign(n_threads, 0);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++)
+        threads.push_back(std::thread(stepping_stone_tiles, this, t, &tr));
+    for (unsigned int t = 0; t < n_threads; t++) threads[t].join();
+
+    for (unsigned int k = 0; k < tr.tile_rg.size(); k++)
+        delete tr.tile_rg[k];
+    for (unsigned int t = 0; t < n_threads; t++) {
+        for (unsigned int c = 0; c < k; c++) counts[c] += tr.dcounts[t][c];
+        interface += tr.dinterface[t];
+    }
+    if (clusters) rebuild_clusters();
+    kmc_valid = false;
+}
+
+SteppingStone64::SteppingStone64(unsigned int l):
+    l(l),
+    field((size_t) l * l, 0)
+{
+    if (l < 2) out_error("The side length has to be at least two.");
+    rg = new RanGen();
+}
+
+SteppingStone64::~SteppingStone64() {
+    delete rg;
+}
+
+void SteppingStone64::randomize(double p) {
+    for (size_t i = 0; i < field.size(); i++) {
+        uint64_t w = 0;
+        for (unsigned int k = 0; k < 64; k++)
+            if (rg->pick_uniform() < p) w |= (uint64_t) 1 << k;
+        field[i] = w;
+    }
+}
+
+void SteppingStone64::run(unsigned long n_steps) {
+    for (unsigned long s = 0; s < n_steps; s++) jump();
+}
+
+void SteppingStone64::count(std::vector<unsigned long> & counts) const {
+    counts.assign(64, 0);
+    for (size_t i = 0; i < field.size(); i++) {
+        uint64_t w = field[i];
+        while (w) {
+            counts[__builtin_ctzll(w)]++;
+            w &= w - 1;
+        }
+    }
+}
+
+SteppingStoneDual::SteppingStoneDual(unsigned int l):
+    l(l)
+{
+    if (l < 2) out_error("The side length has to be at least two.");
+}
+
+double SteppingStoneDual::trace(const std::vector<unsigned long> & sites,
+                                double time, RanGen & rg,
+                                std::vector<unsigned long> & ancestors,
+                                std::vector<unsigned int> & lineage) {
+    unsigned int n = sites.size();
+    // Squares of the alive lineages, and the lineage on each occupied
+    // square.
+    std::vector<unsigned int> alive(n);
+    std::vector<unsigned long> pos(sites);
+    std::unordered_map<unsigned long, unsigned int> occupied;
+    occupied.reserve(2 * n);
+    lineage.resize(n);
+    for (unsigned int i = 0; i < n; i++) {
+        alive[i] = i;
+        lineage[i] = i;
+        if (!occupied.insert(std::make_pair(sites[i], i)).second)
+            out_error("The squares have to be distinct.");
+    }
+
+    double t = 0;
+    while (alive.size() > 1) {
+        t += rg.pick_exponential(1.0 / alive.size());
+        if (t >= time) {
+            t = time;
+            break;
+        }
+        unsigned int k = rg.pick_uniform_int(alive.size());
+        unsigned int i = alive[k];
+        unsigned long x = pos[i];
+        unsigned long y = torus_neighbor(l, x / l, x % l,
+                                         rg.pick_uniform_int(8));
+        occupied.erase(x);
+        std::unordered_map<unsigned long, unsigned int>::iterator
+            it = occupied.find(y);
+        if (it != occupied.end()) {
+            lineage[i] = it->second;
+            alive[k] = alive.back();
+            alive.pop_back();
+        }
+        else {
+            pos[i] = y;
+            occupied.insert(std::make_pair(y, i));
+        }
+    }
+
+    // Resolve chains of merges.
+    ancestors.resize(n);
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int j = i;
+        while (lineage[j] != j) j = lineage[j];
+        lineage[i] = j;
+        ancestors[i] = pos[j];
+    }
+    return t;
+}
+
+/**
+ * Trace a share of the pairs in one thread.
+ */
+void stepping_stone_dual_pairs_thread(unsigned int l, double time,
+                                      unsigned int max_dist,
+                                      unsigned long n_samples,
+                                      RanGen * rgp,
+                                      std::vector<unsigned long> * coalesced,
+                                      std::vector<unsigned long> * same) {
+    RanGen & rg = *rgp;
+    SteppingStoneDual dual(l);
+    std::vector<unsigned long> sites(2), ancestors;
+    std::vector<unsigned int> lineage;
+    for (unsigned int d = 1; d <= max_dist; d++)
+        for (unsigned long k = 0; k < n_samples; k++) {
+            unsigned long x = rg.pick_uniform_int((unsigned long) l * l);
+            sites[0] = x;
+            sites[1] = (x / l) * l + (x % l + d) % l;
+            dual.trace(sites, time, rg, ancestors, lineage);
+            if (lineage[0] == lineage[1]) (*coalesced)[d]++;
+            if (ancestors[0] % 2 == ancestors[1] % 2) (*same)[d]++;
+        }
+}
+
+void stepping_stone_dual_pairs(unsigned int l, double time,
+                               unsigned int max_dist,
+                               unsigned long n_samples,
+                               unsigned int n_threads, unsigned long seed,
+                               std::vector<double> & coalesced,
+                               std::vector<double> & same_color) {
+    if (n_threads == 0) n_threads = 1;
+    if (max_dist >= l) max_dist = l - 1;
+    std::vector<std::vector<unsigned long> >
+        c(n_threads, std::vector<unsigned long>(max_dist+1, 0)),
+        s(n_threads, std::vector<unsigned long>(max_dist+1, 0));
+    // The constructor of RanGen sets global GSL defaults; initialize
+    // the generators before the threads start.
+    std::vector<RanGen*> rg;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        rg.push_back(new RanGen());
+        rg[t]->set_seed(seed + t);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        unsigned long share = n_samples / n_threads;
+        if (t < n_samples % n_threads) share++;
+        threads.push_back(std::thread(stepping_stone_dual_pairs_thread, l,
+                                      time, max_dist, share, rg[t],
+                                      &c[t], &s[t]));
+    }
+    coalesced.assign(max_dist+1, 0);
+    same_color.assign(max_dist+1, 0);
+    coalesced[0] = same_color[0] = 1;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        threads[t].join();
+        for (unsigned int d = 1; d <= max_dist; d++) {
+            coalesced[d] += (double) c[t][d] / n_samples;
+            same_color[d] += (double) s[t][d] / n_samples;
+        }
+        delete rg[t];
+    }
+}
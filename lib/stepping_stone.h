@@ -0,0 +1,412 @@
+/**
+ * @file   stepping_stone.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 19:20:41 2026
+ *
+ * @brief  Stepping stone model on an l-by-l torus.
+ *
+ * Each square of the torus has one of k colors.  In a step, a random
+ * square assumes the color of one of its eight neighbors (see
+ * stepping_stone_model.cpp).  The time is measured in sweeps; during
+ * one sweep, l*l steps are performed.
+ *
+ * The model also runs on other lattices and graphs with neighbor
+ * tables (see lattice.h); then, a random site assumes the color of a
+ * random one of its neighbors.  The default torus computes its
+ * neighbors on the fly and needs no table, which matters on very
+ * large lattices.
+ *
+ * Large lattices can be run on several threads with run_tiled().
+ * The torus is cut into T-by-T tiles, where T is even, and the tiles
+ * are colored like a checkerboard with four classes (row and column
+ * of the tile modulo 2).  Tiles of the same class do not touch, so
+ * that a step in one tile never reads a square that is written in
+ * another tile of the same class.  Time is divided into short
+ * windows.  In each window, the four classes are processed one after
+ * another in random order; all tiles of a class are processed in
+ * parallel and the threads wait at a barrier before the next class.
+ * In a tile with a squares, the number of steps in a window of length
+ * dt is Poisson with mean a*dt and the squares are picked uniformly;
+ * hence, every square is updated at rate one as with random
+ * sequential updating.  Only steps in neighboring tiles within the
+ * same window are reordered (synchronous sublattice algorithm, Shim
+ * and Amar, 2005); this error vanishes with the window length.  Each
+ * tile has its own random number generator, so that the result does
+ * not depend on the number of threads.
+ *
+ * Once domains have formed, most steps copy a color onto a square
+ * that already has it.  run_kmc() performs only the steps that change
+ * the torus.  It keeps the set of active pairs of a square and a
+ * neighbor with different colors; if a of the 8*l*l pairs are active,
+ * the number of steps up to the next active one is geometric with
+ * parameter a/(8*l*l), and the active pair is uniform among the
+ * active ones.  A change of a square affects the 16 pairs it is part
+ * of.
+ *
+ * The number of sites of each color and the length of the interface
+ * (the number of edges between sites of different colors) are kept
+ * up to date with every change of a color; this costs one look at
+ * each neighbor of the changed site.  On request, clusters (connected
+ * sites of the same color) are tracked with union-find: a site that
+ * changes color gets a new node that is joined with the equally
+ * colored neighbors, and the size of its old cluster is reduced.
+ * Union-find cannot split a cluster, so that the number of clusters
+ * may be too low and the largest cluster too large until the
+ * structure is rebuilt from the lattice, which happens after a given
+ * number of changes.  run_tiled() keeps the counts and the interface
+ * but rebuilds the clusters at the end.
+ *
+ */
+
+#ifndef STEPPING_STONE_H
+#define STEPPING_STONE_H
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include "ran_generator.h"
+#include "lattice.h"
+
+/// Offsets of the eight neighbors on the torus.
+extern const int torus_di[8];
+extern const int torus_dj[8];
+
+/**
+ * Index of neighbor d of square (i,j) on an l-by-l torus.
+ *
+ */
+inline unsigned long torus_neighbor(unsigned int l, unsigned int i,
+                                    unsigned int j, unsigned int d) {
+    int ni = (int) i + torus_di[d];
+    int nj = (int) j + torus_dj[d];
+    if (ni < 0) ni += l;
+    else if (ni >= (int) l) ni -= l;
+    if (nj < 0) nj += l;
+    else if (nj >= (int) l) nj -= l;
+    return (unsigned long) ni * l + nj;
+}
+
+class SteppingStone {
+ public:
+    /**
+     * Initialize a torus; the square with row major index i has color
+     * i modulo k.
+     *
+     * @param l the side length; there are l*l squares.
+     * @param k the number of colors.
+     */
+    SteppingStone(unsigned int l, unsigned int k=2);
+
+    /**
+     * Initialize the model on a lattice; the site with row major
+     * index (or number, for graphs) i has color i modulo k.
+     *
+     * @param lat the lattice; it has to outlive the model.
+     * @param k the number of colors.
+     */
+    SteppingStone(const Lattice & lat, unsigned int k=2);
+
+    ~SteppingStone();
+
+    /**
+     * Perform one step: a random square assumes the color of a random
+     * neighbor.
+     *
+     */
+    void jump();
+
+    /**
+     * Perform several steps.
+     *
+     * @param n_steps the number of steps.
+     */
+    void run(unsigned long n_steps);
+
+    /**
+     * Evolve the torus on several threads; only for two dimensional
+     * lattices.
+     *
+     * @param time the number of sweeps.
+     * @param n_threads the number of threads.
+     * @param seed the seed; tile i uses seed+i, the order in which
+     * the classes of tiles are run a seed derived from it.
+     * @param window the length of a time window in sweeps.
+     * @param tile the approximate side length of a tile.
+     */
+    void run_tiled(double time, unsigned int n_threads, unsigned long seed,
+                   double window=0.1, unsigned int tile=256);
+
+    /**
+     * Perform steps with rejection-free kinetic Monte Carlo; stop
+     * early if all squares have the same color.  Only for lattices
+     * where all sites have the same number of neighbors.
+     *
+     * @param n_steps the maximum number of steps.
+     *
+     * @return the number of steps performed.
+     */
+    unsigned long run_kmc(unsigned long n_steps);
+
+    /// The color of square (i,j) of a two dimensional lattice.
+    unsigned char get_color(unsigned int i, unsigned int j) const {
+        return field[site(i, j)];
+    }
+
+    /// The number of sites.
+    unsigned long get_n_sites() const { return n_sites; }
+
+    /// The number of sites with a color.
+    unsigned long count(unsigned char color) const {
+        return color < k ? counts[color] : 0;
+    }
+
+    /// The number of edges between sites of different colors.
+    unsigned long get_interface() const { return interface; }
+
+    /// The number of edges.
+    unsigned long get_n_edges() const { return n_edges; }
+
+    /**
+     * Track clusters of sites with the same color from now on.
+     *
+     * @param rebuild the number of color changes after which the
+     * clusters are rebuilt; 0 for the number of sites.
+     */
+    void track_clusters(unsigned long rebuild=0);
+
+    /// The number of clusters; track_clusters() has to be called
+    /// first.
+    unsigned long get_n_clusters() const { return n_clusters; }
+
+    /// The size of the largest cluster.
+    unsigned long get_largest_cluster() const { return largest; }
+
+    /// The colors of the sites.
+    const std::vector<unsigned char> & get_field() const { return field; }
+
+    /// Print a two dimensional lattice; color 0 is printed as " ",
+    /// color 1 as "+" and further colors as letters.
+    void print(std::ostream & out) const;
+
+    /// Random number generator for jump() and run().
+    RanGen * rg;
+
+ private:
+    /// Number of square (i,j) of a two dimensional lattice.
+    unsigned long site(unsigned int i, unsigned int j) const {
+        unsigned long r = (unsigned long) i * l + j;
+        return lat ? lat->grid_site(r) : r;
+    }
+    /// The number of neighbors of site x.
+    unsigned int degree(unsigned long x) const {
+        return lat ? lat->degree(x) : 8;
+    }
+    /// Neighbor d of site x.
+    unsigned long neighbor(unsigned long x, unsigned int d) const {
+        return lat ? lat->neighbor(x, d) : torus_neighbor(l, x / l, x % l, d);
+    }
+    /// Copy the color of neighbor d onto site x.
+    void copy_neighbor(unsigned long x, unsigned int d) {
+        unsigned char c = field[neighbor(x, d)];
+        if (c != field[x]) recolor(x, c);
+    }
+    /// Change the color of site x to c; add the changes of the counts
+    /// and the interface to dcounts and dinterface.
+    void recolor(unsigned long x, unsigned char c, long * dcounts,
+                 long & dinterface) {
+        unsigned char a = field[x];
+        field[x] = c;
+        dcounts[a]--;
+        dcounts[c]++;
+        for (unsigned int d = 0; d < degree(x); d++) {
+            unsigned char b = field[neighbor(x, d)];
+            dinterface += (b == a) - (b == c);
+        }
+    }
+    /// Change the color of site x to c and update the observables.
+    void recolor(unsigned long x, unsigned char c);
+    /// Count the colors and the interface from scratch.
+    void recount();
+    /// Build the clusters from scratch.
+    void rebuild_clusters();
+    /// Root of union-find node u, with path halving.
+    uint32_t find(uint32_t u) {
+        while (uf_parent[u] != u) {
+            uf_parent[u] = uf_parent[uf_parent[u]];
+            u = uf_parent[u];
+        }
+        return u;
+    }
+    /// Join the clusters of nodes u and v.
+    void join(uint32_t u, uint32_t v);
+    /// Change the size of cluster root u by ds.
+    void resize_cluster(uint32_t u, long ds);
+    /// Lattice; NULL for the torus without neighbor table.
+    const Lattice * lat;
+    /// Side length of two dimensional lattices.
+    unsigned int l;
+    /// Number of sites.
+    unsigned long n_sites;
+    /// Number of colors.
+    unsigned int k;
+    /// Number of sites with each color.
+    std::vector<long> counts;
+    /// Number of edges between different colors, and of all edges.
+    long interface;
+    unsigned long n_edges;
+    /// Union-find of the clusters: the node of each site, the parent
+    /// and the cluster size of each node, the number of clusters of
+    /// each size, and the number of color changes since the last
+    /// rebuild.
+    bool clusters;
+    unsigned long rebuild;
+    unsigned long n_changes;
+    std::vector<uint32_t> uf_node;
+    std::vector<uint32_t> uf_parent;
+    std::vector<uint32_t> uf_size;
+    std::vector<unsigned long> size_hist;
+    unsigned long n_clusters;
+    unsigned long largest;
+    /// Update the active state of pair p = degree*site+direction.
+    void update_pair(unsigned long p);
+    /// Number of neighbors of run_kmc().
+    unsigned int kmc_degree;
+    /// Colors of the squares, row by row.
+    std::vector<unsigned char> field;
+    /// Active pairs of run_kmc(), and their positions in active;
+    /// NO_PAIR if inactive.  They are kept between calls to run_kmc()
+    /// unless other steps have been performed.
+    bool kmc_valid;
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> active_pos;
+    static const uint32_t NO_PAIR = 0xffffffff;
+    /// Thread worker of run_tiled().
+    friend void stepping_stone_tiles(SteppingStone * ss, unsigned int tid,
+                                     void * shared);
+};
+
+/**
+ * 64 replicates of the stepping stone model with two colors, packed
+ * into one 64 bit word per square (multi-spin coding); bit k is the
+ * color of the square in replicate k.  The replicates start from
+ * different configurations but share the random numbers: a step
+ * picks one square and one neighbor and copies the whole word, which
+ * advances all replicates at once.
+ *
+ */
+class SteppingStone64 {
+ public:
+    /**
+     * Initialize a torus with color 0 in all replicates.
+     *
+     * @param l the side length.
+     */
+    SteppingStone64(unsigned int l);
+
+    ~SteppingStone64();
+
+    /**
+     * Color every square of every replicate independently.
+     *
+     * @param p the probability of color 1.
+     */
+    void randomize(double p=0.5);
+
+    /// Perform one step in all replicates.
+    void jump() {
+        unsigned long pick = rg->pick_uniform_int((unsigned long) l * l);
+        unsigned int d = rg->pick_uniform_int(8);
+        field[pick] = field[torus_neighbor(l, pick / l, pick % l, d)];
+    }
+
+    /**
+     * Perform several steps.
+     *
+     * @param n_steps the number of steps.
+     */
+    void run(unsigned long n_steps);
+
+    /**
+     * Count color 1 in each replicate.
+     *
+     * @param counts OUT; length 64.
+     */
+    void count(std::vector<unsigned long> & counts) const;
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    /// Side length.
+    unsigned int l;
+    /// Colors of the squares of all replicates, row by row.
+    std::vector<uint64_t> field;
+};
+
+/**
+ * Coalescing random walks, the dual of the stepping stone model.  The
+ * color of a square at time t is the initial color of the square
+ * where a lineage traced back from it for time t ends.  Each lineage
+ * jumps at rate one (per sweep) to a random one of its eight
+ * neighbors; if the neighbor is occupied by another lineage, the two
+ * merge.  Only the occupied squares are stored, in a hash table, so
+ * that the cost depends on the number of lineages and not on the
+ * size of the torus.
+ *
+ */
+class SteppingStoneDual {
+ public:
+    /**
+     * Initialize.
+     *
+     * @param l the side length of the torus.
+     */
+    SteppingStoneDual(unsigned int l);
+
+    /**
+     * Trace lineages back in time.
+     *
+     * @param sites the squares of the lineages; distinct.
+     * @param time the time in sweeps.
+     * @param rg random number generator.
+     * @param ancestors OUT; the square of the ancestor of each
+     * lineage; if all lineages have merged before time, the square
+     * of the last one at that moment.
+     * @param lineage OUT; the index of the lineage each lineage has
+     * merged into; equal indices mean identity by descent.
+     *
+     * @return the time when a single lineage was left, or time.
+     */
+    double trace(const std::vector<unsigned long> & sites, double time,
+                 RanGen & rg, std::vector<unsigned long> & ancestors,
+                 std::vector<unsigned int> & lineage);
+
+ private:
+    /// Side length.
+    unsigned int l;
+};
+
+/**
+ * Identity of pairs of squares at time t with the dual, on several
+ * threads.  The first square of a pair is random and the second is
+ * d squares to the right; the initial colors alternate as in
+ * SteppingStone.
+ *
+ * @param l the side length.
+ * @param time the time in sweeps.
+ * @param max_dist the largest distance d.
+ * @param n_samples the number of pairs per distance.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param coalesced OUT; the fraction of pairs with a common ancestor,
+ * by distance; length max_dist+1.
+ * @param same_color OUT; the fraction of pairs with the same color.
+ */
+void stepping_stone_dual_pairs(unsigned int l, double time,
+                               unsigned int max_dist,
+                               unsigned long n_samples,
+                               unsigned int n_threads, unsigned long seed,
+                               std::vector<double> & coalesced,
+                               std::vector<double> & same_color);
+
+#endif
@@ -0,0 +1,303 @@
+#include "sweep_coalescent.h"
+#include "tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+SweepCoalescent::SweepCoalescent(unsigned int n, double N, double s,
+                                 const std::vector<double> & r):
+    n(n),
+    N(N),
+    s(s),
+    r(r),
+    m(r.size()),
+    tmrca(r.size()),
+    length(r.size()),
+    pairs(r.size())
+{
+    if (n < 2) out_error("The sample size has to be at least two.");
+    if (s <= 0) out_error("The selection coefficient has to be positive.");
+    for (unsigned int j = 1; j < m; j++)
+        if (r[j] < r[j-1])
+            out_error("Recombination distances have to be increasing.");
+    double eps = 1.0 / (2.0 * N);
+    T = 2.0 * std::log((1.0 - eps) / eps) / s;
+}
+
+double SweepCoalescent::freq(double tau) const {
+    return 1.0 / (1.0 + std::exp(s * (tau - T / 2.0)));
+}
+
+double SweepCoalescent::hazard(double tau, const double * c) const {
+    // With u = exp(s(tau-T/2)), x = 1/(1+u); the antiderivatives of
+    // 1/x, 1/(1-x), 1-x and x are tau + u/s, tau - 1/(su),
+    // log(1+u)/s and tau - log(1+u)/s.
+    double u = std::exp(s * (tau - T / 2.0));
+    double l = std::log1p(u) / s;
+    return c[0] * (tau + u / s) + c[1] * (tau - 1.0 / (s * u))
+        + c[2] * l + c[3] * (tau - l);
+}
+
+void SweepCoalescent::advance(double dt) {
+    for (unsigned int i = 0; i < lineages.size(); i++) {
+        const sweep_lineage & a = lineages[i];
+        for (int j = 0; j <= a.last; j++) {
+            double l = a.leaves[j];
+            if (l == 0) continue;
+            length[j] += dt;
+            pairs[j] += l * (n - l) * dt;
+        }
+    }
+}
+
+void SweepCoalescent::remove(unsigned int i) {
+    std::swap(lineages[i], lineages.back());
+    lineages.pop_back();
+}
+
+void SweepCoalescent::merge(unsigned int i, unsigned int j, double tau) {
+    sweep_lineage & a = lineages[i];
+    const sweep_lineage & b = lineages[j];
+    int last = std::max(a.last, b.last);
+    a.last = -1;
+    for (int k = 0; k <= last; k++) {
+        unsigned int l = a.leaves[k] + b.leaves[k];
+        if (l == n) {
+            tmrca[k] = tau;
+            n_open--;
+            l = 0;
+        }
+        a.leaves[k] = l;
+        if (l > 0) a.last = k;
+    }
+    bool empty = a.last < 0;
+    // Remove the lineage with the higher index first.
+    if (empty && i > j) {
+        remove(i);
+        remove(j);
+    }
+    else {
+        remove(j);
+        if (empty) remove(i == lineages.size() ? j : i);
+    }
+}
+
+void SweepCoalescent::recombine(unsigned int i, RanGen & rg) {
+    sweep_lineage & a = lineages[i];
+    // Positions from k on are right of the break point.
+    double d = rg.pick_uniform() * r[a.last];
+    unsigned int k = std::upper_bound(r.begin(), r.end(), d) - r.begin();
+    int last_left = -1;
+    for (int j = (int) k - 1; j >= 0; j--)
+        if (a.leaves[j] > 0) {
+            last_left = j;
+            break;
+        }
+    if (last_left < 0) {
+        a.in_B = !a.in_B;
+        return;
+    }
+    sweep_lineage b;
+    b.in_B = !a.in_B;
+    b.leaves.assign(m, 0);
+    for (int j = k; j <= a.last; j++) {
+        b.leaves[j] = a.leaves[j];
+        a.leaves[j] = 0;
+    }
+    b.last = a.last;
+    a.last = last_left;
+    lineages.push_back(b);
+}
+
+void SweepCoalescent::simulate(RanGen & rg) {
+    unsigned int i, j;
+    lineages.assign(n, sweep_lineage());
+    for (i = 0; i < n; i++) {
+        lineages[i].in_B = true;
+        lineages[i].leaves.assign(m, 1);
+        lineages[i].last = (int) m - 1;
+    }
+    for (j = 0; j < m; j++) {
+        tmrca[j] = 0;
+        length[j] = 0;
+        pairs[j] = 0;
+    }
+    n_open = m;
+
+    // The sweep, backward in time.
+    double tau = 0;
+    double c[4];
+    while (n_open > 0) {
+        // Coefficients of 1/x, 1/(1-x), 1-x and x of the total rate.
+        double k_B = 0, k_b = 0;
+        c[2] = c[3] = 0;
+        for (i = 0; i < lineages.size(); i++)
+            if (lineages[i].in_B) {
+                k_B++;
+                c[2] += r[lineages[i].last];
+            }
+            else {
+                k_b++;
+                c[3] += r[lineages[i].last];
+            }
+        c[0] = k_B * (k_B - 1) / (4.0 * N);
+        c[1] = k_b * (k_b - 1) / (4.0 * N);
+
+        double h0 = hazard(tau, c);
+        double e = rg.pick_exponential(1.0);
+        if (hazard(T, c) - h0 <= e) {
+            advance(T - tau);
+            tau = T;
+            break;
+        }
+        // Solve hazard(t) - h0 = e by bisection.
+        double lo = tau, hi = T;
+        for (int it = 0; it < 100 && hi - lo > 1e-12 * T; it++) {
+            double mid = 0.5 * (lo + hi);
+            if (hazard(mid, c) - h0 < e) lo = mid;
+            else hi = mid;
+        }
+        advance(hi - tau);
+        tau = hi;
+
+        double x = freq(tau);
+        double rate[4] = {c[0] / x, c[1] / (1.0 - x),
+                          c[2] * (1.0 - x), c[3] * x};
+        double v = rg.pick_uniform() * (rate[0] + rate[1] + rate[2] + rate[3]);
+        int type = 0;
+        while (type < 3 && v >= rate[type]) {
+            v -= rate[type];
+            type++;
+        }
+        bool in_B = (type == 0 || type == 2);
+        if (type < 2) {
+            // Coalescence of two lineages of one background.
+            unsigned int k = (unsigned int) (in_B ? k_B : k_b);
+            unsigned int a = rg.pick_uniform_int(k);
+            unsigned int b = rg.pick_uniform_int(k - 1);
+            if (b >= a) b++;
+            unsigned int ia = 0, ib = 0, idx = 0;
+            for (i = 0; i < lineages.size(); i++) {
+                if (lineages[i].in_B != in_B) continue;
+                if (idx == a) ia = i;
+                if (idx == b) ib = i;
+                idx++;
+            }
+            merge(ia, ib, tau);
+        }
+        else {
+            // Recombination; lineages are picked proportional to the
+            // distance of their rightmost position.
+            double w = rg.pick_uniform() * c[type];
+            for (i = 0; i < lineages.size(); i++) {
+                if (lineages[i].in_B != in_B) continue;
+                w -= r[lineages[i].last];
+                if (w < 0) break;
+            }
+            if (i == lineages.size())
+                for (i = lineages.size(); i-- > 0;)
+                    if (lineages[i].in_B == in_B) break;
+            recombine(i, rg);
+        }
+    }
+
+    // The lineages in B descend from the founder of the sweep.
+    for (;;) {
+        for (i = 0; i < lineages.size() && !lineages[i].in_B; i++);
+        for (j = i + 1; j < lineages.size() && !lineages[j].in_B; j++);
+        if (j >= lineages.size()) break;
+        merge(i, j, tau);
+    }
+    for (i = 0; i < lineages.size(); i++) lineages[i].in_B = false;
+
+    // Neutral coalescent before the sweep.
+    while (n_open > 0) {
+        double k = lineages.size();
+        double dt = rg.pick_exponential(4.0 * N / (k * (k - 1)));
+        advance(dt);
+        tau += dt;
+        unsigned int a = rg.pick_uniform_int(lineages.size());
+        unsigned int b = rg.pick_uniform_int(lineages.size() - 1);
+        if (b >= a) b++;
+        merge(a, b, tau);
+    }
+}
+
+std::vector<double> SweepCoalescent::get_mean_pairwise_time() const {
+    std::vector<double> t(m);
+    for (unsigned int j = 0; j < m; j++)
+        t[j] = pairs[j] / ((double) n * (n-1));
+    return t;
+}
+
+SweepCoalescentStats::SweepCoalescentStats(unsigned int m):
+    n_reps(0),
+    sum_tmrca(m, 0),
+    sum_length(m, 0),
+    sum_pairwise_time(m, 0)
+{
+}
+
+void SweepCoalescentStats::merge(const SweepCoalescentStats & o) {
+    if (o.sum_tmrca.size() != sum_tmrca.size())
+        out_error("Number of positions does not match.");
+    n_reps += o.n_reps;
+    for (unsigned int j = 0; j < sum_tmrca.size(); j++) {
+        sum_tmrca[j] += o.sum_tmrca[j];
+        sum_length[j] += o.sum_length[j];
+        sum_pairwise_time[j] += o.sum_pairwise_time[j];
+    }
+}
+
+/**
+ * Simulate a share of the replicates in one thread.
+ */
+void sweep_coalescent_replicates_thread(unsigned int n, double N, double s,
+                                        const std::vector<double> * r,
+                                        unsigned long n_reps,
+                                        RanGen * rgp,
+                                        SweepCoalescentStats * stats) {
+    RanGen & rg = *rgp;
+    SweepCoalescent c(n, N, s, *r);
+    for (unsigned long k = 0; k < n_reps; k++) {
+        c.simulate(rg);
+        std::vector<double> t = c.get_mean_pairwise_time();
+        stats->n_reps++;
+        for (unsigned int j = 0; j < r->size(); j++) {
+            stats->sum_tmrca[j] += c.get_tmrca()[j];
+            stats->sum_length[j] += c.get_total_length()[j];
+            stats->sum_pairwise_time[j] += t[j];
+        }
+    }
+}
+
+void sweep_coalescent_replicates(unsigned int n, double N, double s,
+                                 const std::vector<double> & r,
+                                 unsigned long n_reps,
+                                 unsigned int n_threads, unsigned long seed,
+                                 SweepCoalescentStats & stats) {
+    if (n_threads == 0) n_threads = 1;
+    std::vector<SweepCoalescentStats>
+        thread_stats(n_threads, SweepCoalescentStats(r.size()));
+    // The constructor of RanGen sets global GSL defaults; initialize
+    // the generators before the threads start.
+    std::vector<RanGen*> rg;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        rg.push_back(new RanGen());
+        rg[t]->set_seed(seed + t);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; t++) {
+        unsigned long share = n_reps / n_threads;
+        if (t < n_reps % n_threads) share++;
+        threads.push_back(std::thread(sweep_coalescent_replicates_thread,
+                                      n, N, s, &r, share, rg[t],
+                                      &thread_stats[t]));
+    }
+    for (unsigned int t = 0; t < n_threads; t++) {
+        threads[t].join();
+        stats.merge(thread_stats[t]);
+        delete rg[t];
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file   sweep_coalescent.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 18:11:37 2026
+ *
+ * @brief  Structured coalescent of linked neutral sites along a
+ * selective sweep.
+ *
+ * A beneficial allele B sweeps through a population of 2N
+ * chromosomes.  Its frequency follows the deterministic logistic
+ * trajectory from 1/(2N) to 1-1/(2N), which takes
+ * \f$ T = 2 \log(2N-1) / s \f$ generations.  A sample of n
+ * chromosomes is taken at the end of the sweep and traced backward in
+ * time.  Each lineage carries ancestral material at some of m neutral
+ * positions; position j has recombination distance r_j from the
+ * selected site.  During the sweep, lineages are in the background B
+ * or b and coalesce within their background at rate 1/(2N x) or
+ * 1/(2N (1-x)) per pair, where x is the frequency of B.  If a
+ * lineage recombines with a chromosome of the other background, the
+ * material right of the break point moves to that background.  At
+ * the start of the sweep, the lineages in B merge into the founder of
+ * the sweep; afterwards, the neutral coalescent with pair rate
+ * 1/(2N) finishes the genealogy.
+ *
+ * The rates change with x, but the integrated rate is known in
+ * closed form, so that the waiting times are drawn exactly without
+ * stepping through generations; the work depends on the number of
+ * events only.  Recombination between lineages of the same background
+ * and recombination after the sweep do not change the genealogy at a
+ * single position and are omitted.  Hence, the genealogies at single
+ * positions have the correct distribution, but the correlation
+ * between positions is not modeled exactly.
+ *
+ * All times are measured in generations.
+ *
+ */
+
+#ifndef SWEEP_COALESCENT_H
+#define SWEEP_COALESCENT_H
+
+#include <iostream>
+#include <vector>
+#include "ran_generator.h"
+
+/// A lineage of the structured coalescent.
+struct sweep_lineage {
+    /// True if the lineage is in the background of the beneficial
+    /// allele.
+    bool in_B;
+    /// Number of sampled leaves below the lineage at each position;
+    /// 0 if the position is not ancestral.
+    std::vector<unsigned int> leaves;
+    /// Rightmost ancestral position; -1 if there is none.
+    int last;
+};
+
+class SweepCoalescent {
+ public:
+    /**
+     * Initialize.
+     *
+     * @param n the sample size.
+     * @param N the diploid population size.
+     * @param s the selection coefficient (logistic growth rate).
+     * @param r the recombination distances of the neutral positions
+     * from the selected site, increasing.
+     */
+    SweepCoalescent(unsigned int n, double N, double s,
+                    const std::vector<double> & r);
+
+    /**
+     * Simulate new genealogies at all positions.
+     *
+     * @param rg random number generator.
+     */
+    void simulate(RanGen & rg);
+
+    /// The number of generations of the sweep.
+    double get_sweep_time() const { return T; }
+
+    /// The times to the most recent common ancestor.
+    const std::vector<double> & get_tmrca() const { return tmrca; }
+
+    /// The total branch lengths.
+    const std::vector<double> & get_total_length() const { return length; }
+
+    /**
+     * The mean times to the most recent common ancestor of two
+     * distinct leaves; 2N under neutrality.
+     *
+     */
+    std::vector<double> get_mean_pairwise_time() const;
+
+ private:
+    /// Frequency of B at time tau before the end of the sweep.
+    double freq(double tau) const;
+    /// Integrated event rate with the coefficients of 1/x, 1/(1-x),
+    /// 1-x and x.
+    double hazard(double tau, const double * c) const;
+    /// Add the branches of the lineages over a time interval.
+    void advance(double dt);
+    /// Merge lineage j into lineage i at time tau.
+    void merge(unsigned int i, unsigned int j, double tau);
+    /// Recombination of lineage i; the material right of the break
+    /// point moves to the other background.
+    void recombine(unsigned int i, RanGen & rg);
+    /// Remove lineage i.
+    void remove(unsigned int i);
+    /// Sample size.
+    unsigned int n;
+    /// Population size.
+    double N;
+    /// Selection coefficient.
+    double s;
+    /// Recombination distances.
+    std::vector<double> r;
+    /// Number of positions.
+    unsigned int m;
+    /// Duration of the sweep.
+    double T;
+    /// Lineages.
+    std::vector<sweep_lineage> lineages;
+    /// Number of positions without most recent common ancestor.
+    unsigned int n_open;
+    /// Results per position.
+    std::vector<double> tmrca;
+    std::vector<double> length;
+    std::vector<double> pairs;
+};
+
+/**
+ * Summary statistics per position over many replicates.
+ *
+ */
+struct SweepCoalescentStats {
+    SweepCoalescentStats(unsigned int m=0);
+    /// Add the statistics of another set of replicates.
+    void merge(const SweepCoalescentStats & o);
+    /// Number of replicates.
+    unsigned long n_reps;
+    /// Sums over the replicates.
+    std::vector<double> sum_tmrca;
+    std::vector<double> sum_length;
+    std::vector<double> sum_pairwise_time;
+};
+
+/**
+ * Simulate independent replicates on several threads.
+ *
+ * @param n the sample size.
+ * @param N the diploid population size.
+ * @param s the selection coefficient.
+ * @param r the recombination distances of the positions.
+ * @param n_reps the number of replicates.
+ * @param n_threads the number of threads.
+ * @param seed the seed; thread i uses seed+i.
+ * @param stats IN/OUT; the replicates are added.
+ */
+void sweep_coalescent_replicates(unsigned int n, double N, double s,
+                                 const std::vector<double> & r,
+                                 unsigned long n_reps,
+                                 unsigned int n_threads, unsigned long seed,
+                                 SweepCoalescentStats & stats);
+
+#endif
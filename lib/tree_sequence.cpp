@@ -0,0 +1,177 @@
+#include "tree_sequence.h"
+#include "tools.h"
+
+#include <algorithm>
+
+TreeSequence::TreeSequence(double L):
+    L(L)
+{
+}
+
+int TreeSequence::add_node(double time) {
+    node_time.push_back(time);
+    return node_time.size() - 1;
+}
+
+void TreeSequence::add_edge(double left, double right, int parent,
+                            int child) {
+    ts_edge e = {left, right, parent, child};
+    edges.push_back(e);
+}
+
+/// Order edges by parent birth time (youngest first), then parent,
+/// child and left end.
+struct ts_edge_order {
+    const std::vector<double> * time;
+    bool operator()(const ts_edge & a, const ts_edge & b) const {
+        double ta = (*time)[a.parent];
+        double tb = (*time)[b.parent];
+        if (ta != tb) return ta > tb;
+        if (a.parent != b.parent) return a.parent < b.parent;
+        if (a.child != b.child) return a.child < b.child;
+        return a.left < b.left;
+    }
+};
+
+/// Order edges by parent, child and left end.
+bool ts_edge_squash_order(const ts_edge & a, const ts_edge & b) {
+    if (a.parent != b.parent) return a.parent < b.parent;
+    if (a.child != b.child) return a.child < b.child;
+    return a.left < b.left;
+}
+
+void TreeSequence::merge_segments(std::vector<segment> & s, int parent,
+                                  std::vector<double> & new_time,
+                                  std::vector<ts_edge> & new_edges,
+                                  std::vector<segment> & out) {
+    std::vector<double> breaks;
+    for (size_t i = 0; i < s.size(); i++) {
+        breaks.push_back(s[i].left);
+        breaks.push_back(s[i].right);
+    }
+    std::sort(breaks.begin(), breaks.end());
+    breaks.erase(std::unique(breaks.begin(), breaks.end()), breaks.end());
+
+    int v = -1;
+    std::vector<int> overlap;
+    for (size_t b = 0; b+1 < breaks.size(); b++) {
+        double l = breaks[b];
+        double r = breaks[b+1];
+        overlap.clear();
+        for (size_t i = 0; i < s.size(); i++)
+            if (s[i].left <= l && s[i].right >= r)
+                overlap.push_back(s[i].node);
+        if (overlap.empty()) continue;
+        segment seg = {l, r, -1};
+        if (overlap.size() == 1) {
+            // No coalescence; the ancestral material passes through.
+            seg.node = overlap[0];
+        }
+        else {
+            // Coalescence; the parent is kept.
+            if (v == -1) {
+                new_time.push_back(node_time[parent]);
+                v = new_time.size() - 1;
+            }
+            for (size_t i = 0; i < overlap.size(); i++) {
+                ts_edge e = {l, r, v, overlap[i]};
+                new_edges.push_back(e);
+            }
+            seg.node = v;
+        }
+        // Extend the previous segment if possible.
+        if (!out.empty() && out.back().node == seg.node &&
+            out.back().right == l)
+            out.back().right = r;
+        else out.push_back(seg);
+    }
+}
+
+void TreeSequence::simplify(const std::vector<int> & samples) {
+    std::vector<double> new_time;
+    std::vector<ts_edge> new_edges;
+    std::vector<std::vector<segment> > ancestry(node_time.size());
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        int u = samples[i];
+        if (u < 0 || (size_t) u >= node_time.size())
+            out_error("Sample is not a node.");
+        new_time.push_back(node_time[u]);
+        segment seg = {0, L, (int) i};
+        ancestry[u].push_back(seg);
+    }
+
+    ts_edge_order order;
+    order.time = &node_time;
+    std::sort(edges.begin(), edges.end(), order);
+
+    std::vector<segment> s;
+    size_t j = 0;
+    while (j < edges.size()) {
+        int u = edges[j].parent;
+        s.clear();
+        for (; j < edges.size() && edges[j].parent == u; j++) {
+            const ts_edge & e = edges[j];
+            const std::vector<segment> & a = ancestry[e.child];
+            for (size_t k = 0; k < a.size(); k++) {
+                if (a[k].right > e.left && e.right > a[k].left) {
+                    segment seg = {std::max(a[k].left, e.left),
+                                   std::min(a[k].right, e.right),
+                                   a[k].node};
+                    s.push_back(seg);
+                }
+            }
+        }
+        if (!s.empty())
+            merge_segments(s, u, new_time, new_edges, ancestry[u]);
+    }
+
+    // Squash edges that are adjacent on the genome.
+    std::sort(new_edges.begin(), new_edges.end(), ts_edge_squash_order);
+    edges.clear();
+    for (size_t k = 0; k < new_edges.size(); k++) {
+        if (!edges.empty() &&
+            edges.back().parent == new_edges[k].parent &&
+            edges.back().child == new_edges[k].child &&
+            edges.back().right == new_edges[k].left)
+            edges.back().right = new_edges[k].right;
+        else edges.push_back(new_edges[k]);
+    }
+    node_time.swap(new_time);
+}
+
+unsigned int TreeSequence::count_samples(int node, double x,
+                                         unsigned int n,
+                                         const std::vector<size_t> & first) {
+    unsigned int c = (unsigned int) node < n ? 1 : 0;
+    for (size_t k = first[node]; k < first[node+1]; k++) {
+        if (edges[k].left <= x && x < edges[k].right)
+            c += count_samples(edges[k].child, x, n, first);
+    }
+    return c;
+}
+
+unsigned long TreeSequence::drop_mutations(double mu, unsigned int n,
+                                           RanGen & rg,
+                                           std::vector<unsigned long> & sfs) {
+    // Index of the first edge of each parent; edges are sorted by
+    // parent after simplify().
+    std::sort(edges.begin(), edges.end(), ts_edge_squash_order);
+    std::vector<size_t> first(node_time.size() + 1, edges.size());
+    for (size_t k = edges.size(); k-- > 0;) first[edges[k].parent] = k;
+    for (size_t u = node_time.size(); u-- > 0;)
+        if (first[u] > first[u+1]) first[u] = first[u+1];
+
+    unsigned long n_mut = 0;
+    for (size_t k = 0; k < edges.size(); k++) {
+        const ts_edge & e = edges[k];
+        double span = node_time[e.child] - node_time[e.parent];
+        unsigned int m = rg.pick_poisson(mu * (e.right - e.left) * span);
+        for (unsigned int i = 0; i < m; i++) {
+            double x = e.left + rg.pick_uniform() * (e.right - e.left);
+            sfs[count_samples(e.child, x, n, first)]++;
+        }
+        n_mut += m;
+    }
+    return n_mut;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file   tree_sequence.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 16:08:27 2026
+ *
+ * @brief  Record genealogies of a forward simulation as a tree
+ * sequence.
+ *
+ * The genealogy along a genome [0, L) is stored in two tables.  A node
+ * is a genome with its birth time (in generations forward in time, so
+ * parents are older and have smaller times).  An edge (left, right,
+ * parent, child) states that the child inherited the interval [left,
+ * right) from the parent.
+ *
+ * Simplification (Kelleher et al., 2018) removes all nodes and edges
+ * that are not ancestral to a given set of samples and keeps only
+ * nodes at which lineages of the samples coalesce.  Afterwards the
+ * samples are the nodes 0, ..., n-1.  Memory then scales with the
+ * retained ancestry of the samples.
+ *
+ * Neutral mutations need not be simulated forward in time; they can
+ * be dropped onto the simplified tree sequence afterwards.
+ *
+ */
+
+#ifndef TREE_SEQUENCE_H
+#define TREE_SEQUENCE_H
+
+#include <vector>
+#include "ran_generator.h"
+
+/// An edge of a tree sequence.
+struct ts_edge {
+    double left;
+    double right;
+    int parent;
+    int child;
+};
+
+class TreeSequence {
+ public:
+    /**
+     * Initialize empty tables.
+     *
+     * @param L the length of the genome.
+     */
+    TreeSequence(double L=1.0);
+
+    /**
+     * Add a node.
+     *
+     * @param time the birth time in generations.
+     *
+     * @return the id of the node.
+     */
+    int add_node(double time);
+
+    /**
+     * Add an edge.
+     *
+     * @param left left end of the inherited interval.
+     * @param right right end of the inherited interval.
+     * @param parent the parent node.
+     * @param child the child node.
+     */
+    void add_edge(double left, double right, int parent, int child);
+
+    /**
+     * Simplify the tables with respect to a set of samples.  The
+     * samples must not be parents of each other.
+     *
+     * @param samples the sample nodes; the new id of samples[i] is i.
+     */
+    void simplify(const std::vector<int> & samples);
+
+    /**
+     * Drop infinite-sites mutations onto the tree sequence.  The
+     * number of mutations on an edge is Poisson with mean mu times
+     * the length of the edge times the number of generations it
+     * spans; the position is uniform on the edge.  Only valid after
+     * simplify() with n samples.
+     *
+     * @param mu the mutation rate per unit genome length and
+     * generation.
+     * @param n the number of samples.
+     * @param rg random number generator.
+     * @param sfs IN/OUT; entry i is increased by the number of
+     * mutations carried by i samples; length n+1.
+     *
+     * @return the number of mutations.
+     */
+    unsigned long drop_mutations(double mu, unsigned int n, RanGen & rg,
+                                 std::vector<unsigned long> & sfs);
+
+    /// The number of nodes.
+    size_t n_nodes() const { return node_time.size(); }
+
+    /// The number of edges.
+    size_t n_edges() const { return edges.size(); }
+
+    /// The time of a node.
+    double get_time(int node) const { return node_time[node]; }
+
+ private:
+    /// A segment of ancestral material that is carried by a node.
+    struct segment {
+        double left;
+        double right;
+        int node;
+    };
+    /// Merge the ancestral segments of the children of a parent.
+    void merge_segments(std::vector<segment> & s, int parent,
+                        std::vector<double> & new_time,
+                        std::vector<ts_edge> & new_edges,
+                        std::vector<segment> & out);
+    /// Count the samples below a node at a position.
+    unsigned int count_samples(int node, double x, unsigned int n,
+                               const std::vector<size_t> & first);
+    /// Genome length.
+    double L;
+    /// Birth times of the nodes.
+    std::vector<double> node_time;
+    /// The edges.
+    std::vector<ts_edge> edges;
+};
+
+#endif
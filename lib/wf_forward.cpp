@@ -0,0 +1,67 @@
+#include "wf_forward.h"
+#include "tools.h"
+
+WFForward::WFForward(gsl_matrix * u, size_t K, unsigned int N,
+                     size_t n_reps):
+    K(K),
+    N(N),
+    n_reps(n_reps),
+    u(u)
+{
+    if (u->size1 != K || u->size2 != K)
+        out_error("Mutation matrix has wrong dimension.");
+    counts = new_zeroes<unsigned int>(K * n_reps);
+    x = new_zeroes<double>(K * n_reps);
+    rg = new RanGen();
+}
+
+WFForward::~WFForward() {
+    delete rg;
+    delete[] counts;
+    delete[] x;
+}
+
+void WFForward::set_state(const unsigned int * n) {
+    unsigned int sum = 0;
+    for (size_t k = 0; k < K; k++) sum += n[k];
+    if (sum != N) out_error("Allele counts do not sum to N.");
+    for (size_t k = 0; k < K; k++)
+        for (size_t r = 0; r < n_reps; r++)
+            counts[k*n_reps + r] = n[k];
+}
+
+void WFForward::evolve() {
+    size_t i, j, r;
+    // Mutation; x_new = u^T x for all replicates.  The innermost
+    // loop runs over the replicates and is contiguous.
+    for (j = 0; j < K * n_reps; j++) x[j] = 0;
+    for (i = 0; i < K; i++) {
+        const unsigned int * n_i = counts + i*n_reps;
+        for (j = 0; j < K; j++) {
+            double u_ij = gsl_matrix_get(u, i, j) / N;
+            if (u_ij == 0) continue;
+            double * x_j = x + j*n_reps;
+            for (r = 0; r < n_reps; r++) x_j[r] += u_ij * n_i[r];
+        }
+    }
+    // Multinomial sampling by conditional binomials.  The loop stops
+    // as soon as all N individuals have been assigned.
+    for (r = 0; r < n_reps; r++) {
+        unsigned int n_left = N;
+        double p_left = 1.0;
+        for (j = 0; j < K; j++) {
+            double p = x[j*n_reps + r];
+            unsigned int n_j = 0;
+            if (n_left == 0) n_j = 0;
+            else if (j == K-1 || p >= p_left) n_j = n_left;
+            else if (p > 0) n_j = rg->pick_binomial(p / p_left, n_left);
+            counts[j*n_reps + r] = n_j;
+            n_left -= n_j;
+            p_left -= p;
+        }
+    }
+}
+
+void WFForward::evolve(unsigned long n_gen) {
+    for (unsigned long g = 0; g < n_gen; g++) evolve();
+}
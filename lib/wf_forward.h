@@ -0,0 +1,88 @@
+/**
+ * @file   wf_forward.h
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 12:20:05 2026
+ *
+ * @brief  Forward simulation of the K-allelic Wright-Fisher model.
+ *
+ * The generations are iterated directly.  Each generation, the
+ * mutation matrix u is applied to the allele frequencies and the new
+ * allele counts are drawn from a multinomial distribution.  Many
+ * replicate populations are run at once; their allele counts are
+ * stored allele by allele (struct of arrays).  Memory is O(K *
+ * n_reps), independent of the number of states of the chain.
+ *
+ */
+
+#ifndef WF_FORWARD_H
+#define WF_FORWARD_H
+
+#include <gsl/gsl_matrix.h>
+#include "ran_generator.h"
+
+class WFForward {
+ public:
+    /**
+     * Initialize the replicate populations.
+     *
+     * @param u the K times K mutation matrix; rows sum to one.
+     * @param K the number of alleles.
+     * @param N the population size.
+     * @param n_reps the number of replicate populations.
+     */
+    WFForward(gsl_matrix * u, size_t K, unsigned int N, size_t n_reps);
+
+    ~WFForward();
+
+    /**
+     * Set the allele counts of all replicates.
+     *
+     * @param n the K allele counts; they have to sum to N.
+     */
+    void set_state(const unsigned int * n);
+
+    /**
+     * Evolve all replicates one generation.
+     *
+     */
+    void evolve();
+
+    /**
+     * Evolve all replicates for some generations.
+     *
+     * @param n_gen the number of generations.
+     */
+    void evolve(unsigned long n_gen);
+
+    /**
+     * Get an allele count.
+     *
+     * @param r the replicate.
+     * @param k the allele.
+     *
+     * @return the number of individuals of replicate r with allele k.
+     */
+    unsigned int get_count(size_t r, size_t k) const {
+        return counts[k*n_reps + r];
+    }
+
+    /// Random number generator.
+    RanGen * rg;
+
+ private:
+    /// Number of alleles.
+    size_t K;
+    /// Population size.
+    unsigned int N;
+    /// Number of replicates.
+    size_t n_reps;
+    /// Mutation matrix.
+    gsl_matrix * u;
+    /// Allele counts; entry k*n_reps+r belongs to allele k of
+    /// replicate r.
+    unsigned int * counts;
+    /// Allele frequencies after mutation; same layout as counts.
+    double * x;
+};
+
+#endif
@@ -6,81 +6,138 @@
  * @brief  Markov Chains - Norris; exercise 1.8.4.; bookshelf Markov
  * chain
  *
+ * A random book is taken and put back in front, in the place of the
+ * first book (see permutation_chain.h; -m selects other moves).
+ *
+ * After a burn in, the visits to each of the n! orders of the books
+ * are counted.  The chain is uniform in the long run, so that the
+ * fraction of time spent in the initial order estimates 1/n!, and the
+ * total variation distance between the visits and the uniform
+ * distribution is printed.
+ *
+ * How fast the chain mixes is answered with -T: then, many replicates
+ * start from the initial order and the total variation distance to
+ * the uniform distribution and the mean number of books out of place
+ * are printed after each step.
+ *
  */
 
 #include <iostream>
 #include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <unistd.h>
 
-#include <gsl/gsl_rng.h>
+#include "permutation_chain.h"
 
 // User interface.
-int n_books = 7;              /**< Number of books in the shelf. */
+unsigned int n_books = 7;       /**< Number of books in the shelf. */
+permutation_move move = MOVE_SWAP_FRONT; /**< How the books are moved. */
 
 // Markov chain settings.
-int n_burn = 10000;
-int n_iter = 1000000;
-
-void jump (int * state_vec, const gsl_rng * r) {
-    int taken = (int) gsl_rng_uniform_int (r, n_books);
-    int tmp = state_vec[0];
-    state_vec[0] = state_vec[taken];
-    state_vec[taken] = tmp;
-}
-
-bool check (int * state_vec) {
-    for (int i = 0; i < n_books; i++) {
-        if (state_vec[i] != i) return false;
-    }
-    return true;
-}
+unsigned long n_burn = 10000;
+unsigned long n_iter = 1000000;
 
-unsigned long int fac (unsigned long int n) {
-    if (n == 1) return 1;
-    return n * fac(n-1);
-}
+// Mixing settings.
+unsigned long n_mix = 0;        /**< Steps of the mixing curve; 0 for none. */
+unsigned long n_reps = 1000000; /**< Replicates of the mixing curve. */
+unsigned int n_threads = 1;     /**< Number of threads. */
+unsigned long seed = 1;         /**< Seed. */
 
-int main ()
+int main (int argc, char *argv[])
 {
-    // Setup random number generator.
-    const gsl_rng_type * t;
-    gsl_rng * r;
+    int c;
+    while ((c = getopt (argc, argv, "n:m:b:i:T:r:t:s:")) != -1)
+        switch (c)
+            {
+            case 'n':
+                n_books = atoi(optarg);
+                break;
+            case 'm':
+                if (std::string(optarg) == "front") move = MOVE_SWAP_FRONT;
+                else if (std::string(optarg) == "transposition")
+                    move = MOVE_TRANSPOSITION;
+                else if (std::string(optarg) == "riffle") move = MOVE_RIFFLE;
+                else {
+                    std::cerr << "Unknown move " << optarg << "." << std::endl;
+                    return 1;
+                }
+                break;
+            case 'b':
+                n_burn = atol(optarg);
+                break;
+            case 'i':
+                n_iter = atol(optarg);
+                break;
+            case 'T':
+                n_mix = atol(optarg);
+                break;
+            case 'r':
+                n_reps = atol(optarg);
+                break;
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 's':
+                seed = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-n books] [-m front|transposition|riffle]"
+                          << " [-b burn in] [-i iterations] [-T mixing steps]"
+                          << " [-r replicates] [-t threads] [-s seed]"
+                          << std::endl;
+                return 1;
+            }
 
-    gsl_rng_env_setup();
-    t = gsl_rng_default;
-    r = gsl_rng_alloc (t);
-    gsl_rng_set (r, 1);
-
-    int state_vec[n_books];
-    for (int i = 0; i < n_books; i++) {
-        state_vec[i] = i;
+    if (n_mix > 0) {
+        std::vector<double> tv, misplaced;
+        permutation_chain_tv(n_books, move, n_mix, n_reps, n_threads, seed,
+                             tv, misplaced);
+        std::cout << "# step, total variation distance, books out of place"
+                  << std::endl;
+        for (unsigned long t = 0; t <= n_mix; t++)
+            std::cout << t << " " << tv[t] << " " << misplaced[t]
+                      << std::endl;
+        return 0;
     }
 
+    RanGen rg;
+    rg.set_seed(seed);
+    PermutationChain shelf(n_books, move);
+    std::vector<uint32_t> hist;
+
     // Burn in phase.
-    for (int i = 0; i < n_burn; i++) {
-        jump(state_vec, r);
-    }
-    
-    int counter = 0;
+    for (unsigned long i = 0; i < n_burn; i++) shelf.step(rg);
+
     // MCMC steps.
-    for (int i = 0; i < n_iter; i++) {
-        jump(state_vec, r);
-        if (check(state_vec)) counter++;
+    shelf.run(n_iter, rg, hist);
+
+    unsigned long n_states = factorial(n_books);
+    unsigned long visited = 0;
+    double tv = 0;
+    for (unsigned long x = 0; x < n_states; x++) {
+        if (hist[x] > 0) visited++;
+        tv += std::fabs((double) hist[x] / n_iter - 1.0 / n_states);
     }
+    tv /= 2;
 
-    // for (int i = 0; i < n_books; i++) {
-    //     std::cout << state_vec[i] << std::endl;
-    // }
+    unsigned long counter = hist[0];
     double rel_occ = (double) counter / (double) n_iter;
-    double n_states = 1.0 / rel_occ;
+    double n_emp = 1.0 / rel_occ;
     std::cout << "The chain returned "
               << counter << " times to its initial state." << std::endl;
     std::cout << "The relative occurrence is "
               << rel_occ << "." << std::endl;
     std::cout << "This corresponds to an empirical number of "
-              << n_states << " states." << std::endl;
+              << n_emp << " states." << std::endl;
     std::cout << "The actual number of states is "
-              << fac(n_books) << "."<< std::endl;
+              << n_states << "."<< std::endl;
+    std::cout << "The chain visited "
+              << visited << " states." << std::endl;
+    std::cout << "The total variation distance to the uniform distribution is "
+              << tv << "." << std::endl;
 
-    gsl_rng_free (r);
     return 0;
 }
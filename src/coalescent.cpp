@@ -0,0 +1,84 @@
+/**
+ * @file   coalescent.cpp
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 15:30:44 2026
+ *
+ * @brief  Neutral statistics of a sample from the Kingman coalescent.
+ *
+ * Instead of evolving a whole population forward in time until the
+ * quantities of interest have settled, genealogies of a sample of n
+ * lineages are simulated backward in time.  Each genealogy takes n-1
+ * coalescence events.  The time to the most recent common ancestor,
+ * the total branch length, the mean pairwise coalescence time (the
+ * expected heterozygosity divided by theta) and, if theta > 0, the
+ * number of segregating sites and the site frequency spectrum are
+ * reported.
+ *
+ * The expected values are
+ * \f{align}{
+ *  E[T_{MRCA}] &= 2(1-1/n), \\
+ *  E[S] &= \theta \sum_{i=1}^{n-1} 1/i, \\
+ *  E[\xi_i] &= \theta / i.
+ * \f}
+ *
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+#include "coalescent.h"
+
+int main(int argc, char *argv[])
+{
+    unsigned int n = 10;        /**< Sample size. */
+    double theta = 1.0;         /**< Scaled mutation rate. */
+    unsigned long n_reps = 100000; /**< Number of genealogies. */
+    unsigned int n_threads = 1; /**< Number of threads. */
+    unsigned long seed = 0;     /**< Seed. */
+    int c;
+
+    while ((c = getopt (argc, argv, "n:m:r:t:s:")) != -1)
+        switch (c)
+            {
+            case 'n':
+                // Sample size.
+                n = atoi(optarg);
+                break;
+            case 'm':
+                // Scaled mutation rate.
+                theta = atof(optarg);
+                break;
+            case 'r':
+                // Number of genealogies.
+                n_reps = atol(optarg);
+                break;
+            case 't':
+                // Number of threads.
+                n_threads = atoi(optarg);
+                break;
+            case 's':
+                // Seed.
+                seed = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-n sample size] [-m theta]"
+                          << " [-r genealogies] [-t threads] [-s seed]"
+                          << std::endl;
+                return 1;
+            }
+
+    std::cout << "Kingman coalescent; sample size " << n
+              << ", theta " << theta << "." << std::endl;
+    CoalescentStats stats(n);
+    coalescent_replicates(n, theta, n_reps, n_threads, seed, stats);
+    stats.print(std::cout);
+
+    double a = 0;
+    for (unsigned int i = 1; i < n; i++) a += 1.0 / i;
+    std::cout << "Expected time to the most recent common ancestor: "
+              << 2.0 * (1.0 - 1.0 / n) << std::endl;
+    std::cout << "Expected number of segregating sites: "
+              << theta * a << std::endl;
+    return 0;
+}
@@ -1,5 +1,8 @@
 #include <iostream>
-#include <gsl/gsl_rng.h>
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include "lockstep.h"
+#include "dtmc.h"
 
 /**
  * @file   cube_mcmc.cpp
@@ -26,154 +29,85 @@
  * 2. the expected number of visits to o until the first return to i;
  * 3. the expected number of steps until the first visit to o.
  *
+ * The replicates are run in lockstep (see lockstep.h); 1. and 2. are
+ * obtained from the same replicates.  The exact values are computed
+ * from the fundamental matrix of the chain with the initial or the
+ * opposite vertex absorbing (see dtmc.h).
+ *
  */
 
-typedef int state_t;
-typedef int move_t;
+typedef unsigned int state_t;
 
 state_t s_init  = 0;            /**< Starting state. */
 state_t s_opposite = 6;         /**< State opposite from the starting state. */
 int n_turns = 100000;           /**< Number of turns to average over. */
-int n_directions = 3;           /**< Number of direction to move to. */
-
-move_t get_next_move (const gsl_rng * r)
-{
-    return (move_t) gsl_rng_uniform_int (r, n_directions);
-}
-
-state_t get_next_state (state_t s, move_t m)
-{
-    if (s == 0) {
-        if (m == 0) return (state_t) 1;
-        if (m == 1) return (state_t) 3;
-        if (m == 2) return (state_t) 4;
-    }
-    if (s == 1) {
-        if (m == 0) return (state_t) 2;
-        if (m == 1) return (state_t) 0;
-        if (m == 2) return (state_t) 5;
-    }
-    if (s == 2) {
-        if (m == 0) return (state_t) 3;
-        if (m == 1) return (state_t) 1;
-        if (m == 2) return (state_t) 6;
-    }
-    if (s == 3) {
-        if (m == 0) return (state_t) 0;
-        if (m == 1) return (state_t) 2;
-        if (m == 2) return (state_t) 7;
-    }
-    if (s == 4) {
-        if (m == 0) return (state_t) 5;
-        if (m == 1) return (state_t) 7;
-        if (m == 2) return (state_t) 0;
-    }
-    if (s == 5) {
-        if (m == 0) return (state_t) 6;
-        if (m == 1) return (state_t) 4;
-        if (m == 2) return (state_t) 1;
-    }
-    if (s == 6) {
-        if (m == 0) return (state_t) 7;
-        if (m == 1) return (state_t) 5;
-        if (m == 2) return (state_t) 2;
-    }
-    if (s == 7) {
-        if (m == 0) return (state_t) 4;
-        if (m == 1) return (state_t) 6;
-        if (m == 2) return (state_t) 3;
-    }
-    throw "Invalid state.";
-}
-
-state_t jump (state_t s, const gsl_rng * r)
-{
-    move_t m       = get_next_move (r);
-    state_t next_s = get_next_state (s, m);
-    return next_s;
-}
+const int n_directions = 3;     /**< Number of direction to move to. */
+const int n_states = 8;         /**< Number of vertices. */
+unsigned long seed = 1;         /**< Seed. */
 
-double expected_steps_return (const gsl_rng * r)
-{
-    state_t s;
-    int counter;
-    int total_counts = 0;
-    double exp;
-    
-    for (int i = 0; i < n_turns; i++) {
-        s = jump (s_init, r);
-        counter = 1;
-        while (s != s_init) {
-            s = jump (s, r);
-            counter++;
-        }
-        total_counts += counter;
-    }
-    exp = (double) total_counts / (double) n_turns;
-    return exp;
-}
+/// The vertices adjacent to each vertex.
+const state_t neighbors[n_states][n_directions] = {
+    {1, 3, 4}, {2, 0, 5}, {3, 1, 6}, {0, 2, 7},
+    {5, 7, 0}, {6, 4, 1}, {7, 5, 2}, {4, 6, 3}};
 
-double expected_visits_o (const gsl_rng * r)
-{
-    state_t s;
-    int visits = 0;
-    double exp;
-    
-    for (int i = 0; i < n_turns; i++) {
-        s = jump (s_init, r);
-        if (s == s_opposite) visits++;
-        while (s != s_init) {
-            s = jump (s, r);
-            if (s == s_opposite) visits++;
-        }
-    }
-    exp = (double) visits / (double) n_turns;
-    return exp;
-}
-
-double expected_steps_to_o (const gsl_rng *r)
+/**
+ * Average the steps and the visits of all replicates.
+ *
+ */
+void average (const Lockstep & ls, double & steps, double & visits)
 {
-    state_t s;
-    int steps = 0;
-    int total_steps = 0;
-    double exp;
-    
-    for (int i = 0; i < n_turns; i++) {
-        s = jump (s_init, r);
-        steps = 1;
-        while (s != s_opposite) {
-            s = jump (s, r);
-            steps++;
-        }
-        total_steps += steps;
+    unsigned long total_steps = 0;
+    unsigned long total_visits = 0;
+    for (unsigned long r = 0; r < ls.get_n_replicates(); r++) {
+        total_steps += ls.get_steps(r);
+        total_visits += ls.get_hits(r);
     }
-    exp = (double) total_steps / (double) n_turns;
-    return exp;    
+    steps = (double) total_steps / ls.get_n_replicates();
+    visits = (double) total_visits / ls.get_n_replicates();
 }
 
 int main(void)
 {
-    const gsl_rng_type * T;
-    gsl_rng * r; 
+    double p[n_states * n_states] = {0};
+    for (int s = 0; s < n_states; s++)
+        for (int m = 0; m < n_directions; m++)
+            p[s * n_states + neighbors[s][m]] = 1.0 / n_directions;
+    Lockstep ls(p, n_states, n_turns, seed);
 
     double exp_return;
     double exp_visits;
     double exp_steps_o;
-    
-    gsl_rng_env_setup ();
-    T = gsl_rng_default;
-    r = gsl_rng_alloc (T);
+    double dummy;
+
+    // Until the return to the initial state, counting the visits of
+    // the opposite state.
+    ls.reset(s_init);
+    ls.set_stop(std::vector<unsigned int>(1, s_init));
+    ls.set_count(std::vector<unsigned int>(1, s_opposite));
+    ls.run(-1);
+    average(ls, exp_return, exp_visits);
+
+    // Until the first visit of the opposite state.
+    ls.reset(s_init);
+    ls.set_stop(std::vector<unsigned int>(1, s_opposite));
+    ls.run(-1);
+    average(ls, exp_steps_o, dummy);
 
-    exp_return = expected_steps_return (r);
-    exp_visits = expected_visits_o (r);
-    exp_steps_o = expected_steps_to_o (r);
+    // Exact values.
+    gsl_matrix_view pm = gsl_matrix_view_array(p, n_states, n_states);
+    DTMC chain(&pm.matrix);
+    std::vector<double> t_to_o;
+    chain.absorption_times(std::vector<state>(1, s_opposite), t_to_o);
     
     std::cout << "Expected number of jumps before returing to the inital state: ";
-    std::cout << exp_return << std::endl;
+    std::cout << exp_return << " (exact " << chain.return_time(s_init)
+              << ")" << std::endl;
     std::cout << "Expected number of visits of the opposite state: ";
-    std::cout << exp_visits << std::endl;
+    std::cout << exp_visits << " (exact "
+              << chain.visits_before_return(s_init, s_opposite) << ")"
+              << std::endl;
     std::cout << "Expected number of steps to the opposite state: ";
-    std::cout << exp_steps_o << std::endl;
-    gsl_rng_free (r);
+    std::cout << exp_steps_o << " (exact " << t_to_o[s_init] << ")"
+              << std::endl;
     return 0;
 }
@@ -1,5 +1,6 @@
 #include <iostream>
-#include <gsl/gsl_rng.h>
+#include <vector>
+#include "dtmc.h"
 
 /**
  * @file   ehrenfest_mcmc.cpp
@@ -20,6 +21,8 @@
  * The transition probabilites are as follows:
  * \image html ehrenfest_mcmc_transition_probabilities.png
  *
+ * The chain is run with DTMC (see dtmc.h) on sparse rows.
+ *
  * A simulation result:
  * \image html ehrenfest_mcmc_simulation.png
  * 
@@ -47,47 +50,27 @@ double get_q (unsigned int i, unsigned int N)
     return (double) i / (double) N;
 }
 
-/**
- * Let the chain jump from i to either i+1 or i-1.
- *
- * @param i Current state.
- * @param N Total number of particles in the box.
- * @param r GSL random number generator.
- *
- * @return New state.
- */
-unsigned int jump (unsigned int i, unsigned int N, gsl_rng * r)
-{
-    // double p = get_p (i, N);
-    double q = get_q (i, N);
-
-    double s = gsl_rng_uniform (r);
-    if (s < q) {
-        return i-1;
-    }
-    else {
-        return i+1;
-    }
-}
-
 int main(void)
 {
-    const gsl_rng_type * T;
-    gsl_rng * r;
-
-    gsl_rng_env_setup ();
-    T = gsl_rng_default;
-    r = gsl_rng_alloc (T);
-
-    unsigned int states[n_iter];
-    states[0] = i_start;
-    std::cout << states[0] << std::endl;
-
-    for (unsigned int j = 1; j < n_iter; j++) {
-        states[j] = jump (states[j-1], N, r);
-        std::cout << states[j] << std::endl;
+    std::vector<std::vector<state> > cols(N+1);
+    std::vector<std::vector<double> > probs(N+1);
+    for (unsigned int i = 0; i <= N; i++) {
+        double q = get_q (i, N);
+        if (i > 0) {
+            cols[i].push_back(i-1);
+            probs[i].push_back(q);
+        }
+        if (i < N) {
+            cols[i].push_back(i+1);
+            probs[i].push_back(1-q);
+        }
     }
+    DTMC chain(N+1, cols, probs);
+    chain.set_state(i_start);
+
+    std::cout << chain.get_state() << std::endl;
+    for (unsigned int j = 1; j < n_iter; j++)
+        std::cout << chain.jump() << std::endl;
 
-    gsl_rng_free (r);
     return 0;
 }
@@ -0,0 +1,127 @@
+/**
+ * @file   forward_wright_fisher.cpp
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 17:24:51 2026
+ *
+ * @brief  Individual-based Wright-Fisher simulation with selected
+ * sites and recombination; neutral diversity from the recorded tree
+ * sequence.
+ *
+ * A population of N haploid genomes evolves forward in time.  The
+ * selected sites are simulated explicitly; neutral variation is not.
+ * Instead, the genealogy of the genomes is recorded and simplified
+ * periodically.  At the end, the tree sequence of a sample of n
+ * genomes is extracted and neutral infinite-sites mutations with
+ * rate mu per genome and generation are dropped onto it.  The number
+ * of segregating sites and the site frequency spectrum are reported.
+ * Without selection and after sufficiently many generations, the
+ * expected number of segregating sites is \f$ 2 N \mu \sum_{i=1}^{n-1}
+ * 1/i \f$ (haploid population).
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <unistd.h>
+#include "forward_wf.h"
+
+int main(int argc, char *argv[])
+{
+    unsigned int N = 1000;      /**< Population size. */
+    unsigned long n_gen = 10000; /**< Number of generations. */
+    unsigned int n_sel = 100;   /**< Number of selected sites. */
+    double s = 0.0;             /**< Selection coefficient. */
+    double r = 1.0;             /**< Expected crossovers per genome. */
+    double u = 0.0;             /**< Mutation rate per selected site. */
+    double mu = 0.001;          /**< Neutral mutation rate per genome. */
+    unsigned int n = 10;        /**< Sample size. */
+    unsigned int interval = 100; /**< Generations between simplifications. */
+    unsigned long seed = 0;     /**< Seed. */
+    int c;
+
+    while ((c = getopt (argc, argv, "N:g:l:S:r:u:m:n:i:s:")) != -1)
+        switch (c)
+            {
+            case 'N':
+                N = atoi(optarg);
+                break;
+            case 'g':
+                n_gen = atol(optarg);
+                break;
+            case 'l':
+                n_sel = atoi(optarg);
+                break;
+            case 'S':
+                s = atof(optarg);
+                break;
+            case 'r':
+                r = atof(optarg);
+                break;
+            case 'u':
+                u = atof(optarg);
+                break;
+            case 'm':
+                mu = atof(optarg);
+                break;
+            case 'n':
+                n = atoi(optarg);
+                break;
+            case 'i':
+                interval = atoi(optarg);
+                break;
+            case 's':
+                seed = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-N population size] [-g generations]"
+                          << " [-l selected sites] [-S selection coefficient]"
+                          << " [-r crossovers] [-u selected mutation rate]"
+                          << " [-m neutral mutation rate] [-n sample size]"
+                          << " [-i simplification interval] [-s seed]"
+                          << std::endl;
+                return 1;
+            }
+    if (n > N) n = N;
+
+    ForwardWF pop(N, n_sel, s, r, u, interval);
+    pop.rg->set_seed(seed);
+
+    std::cout << "Forward Wright-Fisher; N " << N << ", " << n_sel
+              << " selected sites, s " << s << ", r " << r
+              << ", u " << u << "." << std::endl;
+    pop.evolve(n_gen);
+
+    double mean_freq = 0;
+    unsigned int n_fixed = 0;
+    for (unsigned int k = 0; k < n_sel; k++) {
+        double f = pop.derived_frequency(k);
+        mean_freq += f;
+        if (f == 1.0) n_fixed++;
+    }
+    if (n_sel > 0) mean_freq /= n_sel;
+    std::cout << "Generations: " << pop.get_generation() << std::endl;
+    std::cout << "Mean derived frequency at selected sites: "
+              << mean_freq << std::endl;
+    std::cout << "Fixed derived alleles: " << n_fixed << std::endl;
+
+    TreeSequence & ts = pop.sample(n);
+    std::cout << "Tree sequence of " << n << " samples: "
+              << ts.n_nodes() << " nodes, " << ts.n_edges() << " edges."
+              << std::endl;
+
+    std::vector<unsigned long> sfs(n+1, 0);
+    unsigned long S = ts.drop_mutations(mu, n, *pop.rg, sfs);
+    double a = 0;
+    for (unsigned int i = 1; i < n; i++) a += 1.0 / i;
+    std::cout << "Segregating sites: " << S << std::endl;
+    std::cout << "Expected under neutrality: " << 2.0 * N * mu * a
+              << std::endl;
+    std::cout << "Site frequency spectrum:" << std::endl;
+    for (unsigned int i = 1; i < n; i++)
+        std::cout << std::setw(4) << i << std::setw(10) << sfs[i]
+                  << std::endl;
+
+    return 0;
+}
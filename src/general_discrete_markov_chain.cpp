@@ -10,14 +10,24 @@
  * and print the proportion of time spent in each state.  This should
  * match the stationary distribution.
  *
+ * The iterations are shared by n_reps replicates that start in
+ * s_init and run in lockstep (see lockstep.h).  Each replicate is
+ * burnt in for n_burn steps before its visits are counted, so that
+ * the many short runs do not overweight the transient.  For comparison, the
+ * stationary distribution pi is computed as a row of P^n for a very
+ * large n by repeated squaring (see dtmc.h); P is assumed to be
+ * irreducible and aperiodic.
+ *
  * @todo Object oriented programming.
  * 
  */
 
 #include <iostream>
 #include <iomanip>
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
+#include <vector>
+#include <gsl/gsl_matrix.h>
+#include "lockstep.h"
+#include "dtmc.h"
 
 //////////////////////////////////////////////////////////////////////
 // User interface.
@@ -30,23 +40,12 @@ double trans_matrix[] = { 0.1,  0.4,  0.4,  0.1,
                           0.33, 0.33, 0.33, 0.01};
 //////////////////////////////////////////////////////////////////////
 // Markov chain settings.
+unsigned int n_burn = 10000;    /**< Burn in steps of each replicate. */
 unsigned int n_iter = 10000000;
+unsigned int n_reps = 1024;     /**< Number of replicates. */
+unsigned long seed = 1;         /**< Seed. */
 
 //////////////////////////////////////////////////////////////////////
-/**
- * Perform a single jump of the discrete Markov chain.
- * 
- * @param G A GSL discrete random number lookup table for the current
- * state.
- * @param R A random number generator.
- * 
- * @return New state.
- */
-int jump(const gsl_ran_discrete_t * G, const gsl_rng * R)
-{
-    return gsl_ran_discrete (R, G);
-}
-
 void pp_matrix (double * M, size_t r, size_t c) {
     for (unsigned int i = 0; i < r; i++) {
         for (unsigned int j = 0; j < c; j++) {
@@ -62,29 +61,9 @@ void pp_matrix (double * M, size_t r, size_t c) {
 
 int main ()
 {
-    unsigned int counter_l[n_states];
-    unsigned int s = s_init;
-    const gsl_rng_type * T;
-    gsl_rng * R;
-
-    gsl_ran_discrete_t * G[n_states];
-    const double * P[n_states];
-
-    // Setup counter.
-    for (unsigned int i = 0; i < n_states; i++)
-        counter_l[i] = 0;
-
-    // Setup random number generator.
-    gsl_rng_env_setup();
-    T = gsl_rng_default;
-    R = gsl_rng_alloc(T);
-    gsl_rng_set (R, 1);
-
-    // Setup discrete random number generator.
-    for (unsigned int i = 0; i < n_states; i++) {
-        P[i] = &trans_matrix[i*n_states];
-        G[i] = gsl_ran_discrete_preproc (n_states, P[i]);
-    }
+    Lockstep ls(trans_matrix, n_states, n_reps, seed);
+    ls.reset(s_init);
+    std::vector<unsigned long> counter_l;
 
     // Output information.
     std::cout << "The transition probability matrix P is:" << std::endl;
@@ -93,30 +72,35 @@ int main ()
     std::cout << "The starting state is: " << s_init << std::endl;
 
     // Run the chain.
-    for (unsigned int i = 0; i < n_iter; i++) {
-        s = jump(G[s], R);
-        counter_l[s]++;
-    }
+    ls.run(n_burn);
+    unsigned int n_steps = n_iter / n_reps;
+    ls.run_occupancy(n_steps, counter_l);
+    n_iter = n_steps * n_reps;
+
+    // Stationary distribution.
+    gsl_matrix_view P = gsl_matrix_view_array(trans_matrix, n_states, n_states);
+    DTMC chain(&P.matrix);
+    std::vector<double> pi(n_states, 0);
+    pi[s_init] = 1;
+    chain.distribution(1ul << 40, pi);
 
     // Summarize results.
     std::cout << n_iter << " iterations of the Markov chain have been performed."
               << std::endl;
-    std::cout << "The proportion of time t spent in each state s is:"
+    std::cout << "The proportion of time t spent in each state s and the"
+              << std::endl
+              << "stationary probability pi of s are:"
               << std::endl << std::endl;
-    std::cout << "s\tt" << std::endl;
+    std::cout << "s\tt\tpi" << std::endl;
     for (unsigned int i = 0; i < n_states; i++) {
         double prop = (double) counter_l[i] / (double) n_iter;
         std::cout
             << std::setprecision(3)
-            << i <<"\t" << prop << std::endl;
+            << i <<"\t" << prop << "\t" << pi[i] << std::endl;
     }
     std::cout << std::endl;
     std::cout << "This should match the stationary distribution of P."
               << std::endl;
 
-    // Free memory.
-    for (unsigned int i = 0; i < n_states; i++)
-        gsl_ran_discrete_free (G[i]);
-    gsl_rng_free (R);
     return 0;
 }
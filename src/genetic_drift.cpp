@@ -1,6 +1,9 @@
 #include <iostream>
+#include <cstdlib>
+#include <unistd.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
+#include "drift.h"
 
 /**
  * @file   genetic_drift.cpp
@@ -12,6 +15,17 @@
  * Simulate genetic drift using the Wright-Fisher model; the GSL
  * library is used for random number generation.  Apart from that the
  * code is pretty straight forward to read.
+ *
+ * With -r, many independent replicates are run on -t threads and only
+ * the fixation probability, the mean and variance of the time to
+ * fixation and a histogram of fixation times are printed.  With -d
+ * eps, the replicates take multi-generation diffusion steps of
+ * relative size eps away from the boundaries, which makes large N
+ * feasible.
+ *
+ * With -L, many independent loci of one population are evolved
+ * together; the number of segregating loci and the mean
+ * heterozygosity are printed each generation.
  * 
  */
 
@@ -36,13 +50,87 @@ evolve_population (unsigned int k, unsigned int N, const gsl_rng * r)
 }
 
 int
-main (void)
+main (int argc, char *argv[])
 {
   unsigned int N = 1000;        /* Total population size. */
   unsigned int k = 500;         /* Initial number of individuals with
                                    allele one. */
+  unsigned long n_reps = 0;     /* Number of replicates; 0 runs a
+                                   single population and prints it. */
+  unsigned int n_threads = 1;   /* Number of threads. */
+  unsigned long seed = 0;       /* Seed of the replicates. */
+  size_t n_bins = 100;          /* Bins of fixation time histogram. */
+  double eps = 0;               /* Relative size of diffusion steps;
+                                   0 for exact steps only. */
+  size_t n_loci = 0;            /* Number of independent loci. */
 
   unsigned int i = 0;
+  int c;
+
+  while ((c = getopt (argc, argv, "N:k:r:t:s:b:d:L:")) != -1)
+    switch (c)
+      {
+      case 'N':
+        N = atoi (optarg);
+        break;
+      case 'k':
+        k = atoi (optarg);
+        break;
+      case 'r':
+        n_reps = atol (optarg);
+        break;
+      case 't':
+        n_threads = atoi (optarg);
+        break;
+      case 's':
+        seed = atol (optarg);
+        break;
+      case 'b':
+        n_bins = atoi (optarg);
+        break;
+      case 'd':
+        eps = atof (optarg);
+        break;
+      case 'L':
+        n_loci = atol (optarg);
+        break;
+      default:
+        std::cerr << "Usage: " << argv[0]
+                  << " [-N size] [-k count] [-r replicates]"
+                  << " [-t threads] [-s seed] [-b bins] [-d eps]"
+                  << " [-L loci]" << std::endl;
+        return 1;
+      }
+
+  if (n_loci > 0) {
+    DriftLoci loci (N, n_loci, k);
+    loci.rg->set_seed (seed);
+    std::cout << "Simulation of genetic drift; " << n_loci
+              << " loci." << std::endl;
+    std::cout << "Starting values: k = " << k << ", N = " << N << std::endl;
+    std::cout << "generation segregating heterozygosity" << std::endl;
+    while (loci.n_segregating () > 0) {
+      loci.evolve ();
+      std::cout << loci.get_generation () << " "
+                << loci.n_segregating () << " "
+                << loci.mean_heterozygosity () << std::endl;
+    }
+    std::cout << "Loci fixed for allele one: " << loci.n_fixed_one ()
+              << std::endl;
+    return 0;
+  }
+
+  if (n_reps > 0) {
+    /* Fixation times beyond 20N generations are rare; collect them
+       in the last bin. */
+    FixationStats stats (20 * (unsigned long) N, n_bins);
+    std::cout << "Simulation of genetic drift; " << n_reps
+              << " replicates." << std::endl;
+    std::cout << "Starting values: k = " << k << ", N = " << N << std::endl;
+    drift_replicates (N, k, n_reps, n_threads, seed, stats, eps);
+    stats.print (std::cout);
+    return 0;
+  }
 
   const gsl_rng_type * T;
   gsl_rng * r;
@@ -27,23 +27,60 @@
  * The linkage disequlibrium is:
  * - \f$D = x_1 - p_A * p_B\f$
  *
+ * The recursions are iterated for a grid of population sizes N,
+ * heterozygous coefficients h, selection coefficients s and
+ * recombination rates r (see get_het_f_batch()).  Grid points are
+ * processed HH_LANES at a time in the lanes of GCC vector types and
+ * distributed over threads; a lane whose point has finished takes
+ * the next one.  Alternatively, a continuous-time approximation is
+ * solved with an adaptive integrator (see get_het_f_ode()).  Note
+ * that for h close to 0 or 1, the recursions converge slowly, because
+ * A1 or A2 is then only exposed to selection as a homozygote.
+ *
+ * Besides the deterministic recursions, sweeps in a population of 2N
+ * chromosomes can be simulated stochastically with -r (see
+ * sweep_replicates()).
+ * Each generation, the haplotype frequencies after selection and
+ * recombination are given by the recursions; the next generation is
+ * sampled from them.  The number of A1 chromosomes is binomial and
+ * does not depend on the B locus; given this number, the haplotype
+ * counts in the A1 and A2 backgrounds are binomial again.  Because
+ * the selected locus does not depend on the neutral ones, one
+ * trajectory of A1 can be shared by many neutral loci with different
+ * recombination rates (multi-locus mode); each of them has the
+ * correct two-locus distribution.
+ *
+ * Sweeps are conditioned on fixation of A1 without rejection.  The
+ * trajectory is drawn from the Doob h-transformed chain with the
+ * transition probabilities \f$P_{ij} u(j) / \sum_k P_{ik} u(k)\f$,
+ * where \f$u\f$ is the diffusion approximation of the fixation
+ * probability.  The transition probabilities are tabulated within
+ * twelve standard deviations of the mean and sampled by inversion.
+ *
  */
 
 
 
 #include <stdio.h>
-
-#define h (0.5)		/* heterozygous coefficient */
-#define s (0.1)		/* selection coefficient */
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_odeiv2.h>
 
 /** 
  * Marginal fitness 1.
  * 
  * @param p 
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
  * 
  * @return 
  */
-double w_bar_1 (double p)
+double w_bar_1 (double p, double h, double s)
 {
     double q = 1 - p;
     return 1.0 - q*h*s;
@@ -53,10 +90,12 @@ double w_bar_1 (double p)
  * Marginal fitness 3.
  * 
  * @param p 
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
  * 
  * @return 
  */
-double w_bar_3 (double p)
+double w_bar_3 (double p, double h, double s)
 {
     double q = 1 -p;
     return 1.0 - p*h*s - q*s;
@@ -66,10 +105,12 @@ double w_bar_3 (double p)
  * Mean fitness.
  * 
  * @param p 
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
  * 
  * @return 
  */
-double w_bar (double p)
+double w_bar (double p, double h, double s)
 {
   double q = 1-p;
   return 1 - 2*p*q*h*s - q*q*s;
@@ -80,20 +121,23 @@ double w_bar (double p)
  * 
  * @param x1 
  * @param x2 
- * @param x3 
- * @param x4 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
  * @param r 
+ * @param h 
+ * @param s 
  * 
  * @return 
  */
-double delta_x1 (double x1, double x2, double x3, double x4, double r) {
+double delta_x1 (double x1, double x2, double x3, double x4, double r,
+		 double h, double s) {
   double p = x1 + x2;
   double q = 1-p;
   double num;
 
-  num = x1 * (w_bar_1 (p) - w_bar (p)) - r*(1-h*s) * (x1*x4 - x2*x3);
+  num = x1 * (w_bar_1 (p, h, s) - w_bar (p, h, s))
+    - r*(1-h*s) * (x1*x4 - x2*x3);
 
-  return num / w_bar (p);
+  return num / w_bar (p, h, s);
 }
 
 /** 
@@ -101,20 +145,23 @@ double delta_x1 (double x1, double x2, double x3, double x4, double r) {
  * 
  * @param x1 
  * @param x2 
- * @param x3 
- * @param x4 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
  * @param r 
+ * @param h 
+ * @param s 
  * 
  * @return 
  */
-double delta_x2 (double x1, double x2, double x3, double x4, double r) {
+double delta_x2 (double x1, double x2, double x3, double x4, double r,
+		 double h, double s) {
   double p = x1 + x2;
   double q = 1-p;
   double num;
 
-  num = x2 * (w_bar_1 (p) - w_bar (p)) + r*(1-h*s) * (x1*x4 - x2*x3);
+  num = x2 * (w_bar_1 (p, h, s) - w_bar (p, h, s))
+    + r*(1-h*s) * (x1*x4 - x2*x3);
 
-  return num / w_bar (p);
+  return num / w_bar (p, h, s);
 }
 
 /** 
@@ -122,20 +169,23 @@ double delta_x2 (double x1, double x2, double x3, double x4, double r) {
  * 
  * @param x1 
  * @param x2 
- * @param x3 
- * @param x4 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
  * @param r 
+ * @param h 
+ * @param s 
  * 
  * @return 
  */
-double delta_x3 (double x1, double x2, double x3, double x4, double r) {
+double delta_x3 (double x1, double x2, double x3, double x4, double r,
+		 double h, double s) {
   double p = x1 + x2;
   double q = 1-p;
   double num;
 
-  num = x3 * (w_bar_3 (p) - w_bar (p)) + r*(1-h*s) * (x1*x4 - x2*x3);
+  num = x3 * (w_bar_3 (p, h, s) - w_bar (p, h, s))
+    + r*(1-h*s) * (x1*x4 - x2*x3);
 
-  return num / w_bar (p);
+  return num / w_bar (p, h, s);
 }
 
 /** 
@@ -143,20 +193,23 @@ double delta_x3 (double x1, double x2, double x3, double x4, double r) {
  * 
  * @param x1 
  * @param x2 
- * @param x3 
- * @param x4 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
  * @param r 
+ * @param h 
+ * @param s 
  * 
  * @return 
  */
-double delta_x4 (double x1, double x2, double x3, double x4, double r) {
+double delta_x4 (double x1, double x2, double x3, double x4, double r,
+		 double h, double s) {
   double p = x1 + x2;
   double q = 1-p;
   double num;
 
-  num = x4 * (w_bar_3 (p) - w_bar (p)) - r*(1-h*s) * (x1*x4 - x2*x3);
+  num = x4 * (w_bar_3 (p, h, s) - w_bar (p, h, s))
+    - r*(1-h*s) * (x1*x4 - x2*x3);
 
-  return num / w_bar (p);
+  return num / w_bar (p, h, s);
 }
 
 /** 
@@ -164,16 +217,17 @@ double delta_x4 (double x1, double x2, double x3, double x4, double r) {
  * 
  * @param x1 
  * @param x2 
- * @param x3 
- * @param x4 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
  * @param r 
+ * @param h 
+ * @param s 
  * @param eps 
  * 
  * @return 
  */
 double get_het_f (double x1, double x2,
 		  double x3, double x4,
-		  double r, double eps) {
+		  double r, double h, double s, double eps) {
   double pa;
   double qa;
   double pb;
@@ -189,10 +243,10 @@ double get_het_f (double x1, double x2,
     pa = x1 + x2;
     qa = 1.0 - pa;
 
-    dx1 = delta_x1 (x1, x2, x3, x4, r);
-    dx2 = delta_x2 (x1, x2, x3, x4, r);
-    dx3 = delta_x3 (x1, x2, x3, x4, r);
-    dx4 = delta_x4 (x1, x2, x3, x4, r);
+    dx1 = delta_x1 (x1, x2, x3, x4, r, h, s);
+    dx2 = delta_x2 (x1, x2, x3, x4, r, h, s);
+    dx3 = delta_x3 (x1, x2, x3, x4, r, h, s);
+    dx4 = delta_x4 (x1, x2, x3, x4, r, h, s);
 
     x1 = x1 + dx1;
     x2 = x2 + dx2;
@@ -206,35 +260,752 @@ double get_het_f (double x1, double x2,
   return het_f;
 }
 
-int main(void) {
-  int i;
-  FILE *fp;
+/** 
+ * Parameters of the continuous-time recursions.
+ */
+typedef struct {
+  double r;
+  double h;
+  double s;
+} hh_ode_params;
+
+/** 
+ * Right hand side of the continuous-time recursions with the
+ * frequency p of A1 as independent variable.  The state is y =
+ * (x1, x3); x2 = p - x1 and x4 = 1 - p - x3.  The rates of change
+ * per generation are those of delta_x1() and delta_x3(); they are
+ * divided by the rate of change of p.
+ * 
+ * @param p 
+ * @param y 
+ * @param dydp OUT
+ * @param params hh_ode_params
+ * 
+ * @return GSL_SUCCESS
+ */
+int hh_ode_rhs (double p, const double y[], double dydp[], void *params)
+{
+  const hh_ode_params *par = params;
+  double x1 = y[0];
+  double x3 = y[1];
+  double x2 = p - x1;
+  double x4 = 1.0 - p - x3;
+  double q = 1.0 - p;
+  double hs = par->h * par->s;
+  double wb = 1.0 - 2.0*p*q*hs - q*q*par->s;
+  double w1 = 1.0 - q*hs - wb;
+  double w3 = 1.0 - p*hs - q*par->s - wb;
+  double rd = par->r * (1.0 - hs) * (x1*x4 - x2*x3);
+  /* The common factor 1/wb cancels. */
+  double dp = p * w1;
+
+  dydp[0] = (x1*w1 - rd) / dp;
+  dydp[1] = (x3*w3 + rd) / dp;
+  return GSL_SUCCESS;
+}
+
+/** 
+ * Final heterozygosity of the continuous-time approximation of the
+ * recursions, solved with the adaptive Runge-Kutta-Fehlberg (4, 5)
+ * method.  Because p increases monotonically, it is used as
+ * independent variable and the integration stops exactly at the
+ * threshold 1-eps.  For small s, the number of steps is much smaller
+ * than the number of generations of get_het_f().
+ * 
+ * @param x1 
+ * @param x2 
+ * @param x3 x4 = 1 - x1 - x2 - x3 is implied
+ * @param r 
+ * @param h 
+ * @param s 
+ * @param eps 
+ * @param tol relative and absolute error per step
+ * 
+ * @return 
+ */
+double get_het_f_ode (double x1, double x2, double x3,
+		      double r, double h, double s,
+		      double eps, double tol) {
+  hh_ode_params par;
+  gsl_odeiv2_system sys;
+  gsl_odeiv2_step *step = gsl_odeiv2_step_alloc (gsl_odeiv2_step_rkf45, 2);
+  gsl_odeiv2_control *con = gsl_odeiv2_control_y_new (tol, tol);
+  gsl_odeiv2_evolve *evo = gsl_odeiv2_evolve_alloc (2);
+  double y[2];
+  double p = x1 + x2;
+  double p_end = 1.0 - eps;
+  double dp = eps;
+  double pb;
 
-  /* Diploid population size. */
-  int N = 500;
-  /* Recombination rate. */
+  par.r = r;
+  par.h = h;
+  par.s = s;
+  sys.function = hh_ode_rhs;
+  sys.jacobian = NULL;
+  sys.dimension = 2;
+  sys.params = &par;
+  y[0] = x1;
+  y[1] = x3;
+
+  while (p < p_end)
+    if (gsl_odeiv2_evolve_apply (evo, con, step, &sys, &p, p_end, &dp, y)
+	!= GSL_SUCCESS)
+      break;
+
+  gsl_odeiv2_evolve_free (evo);
+  gsl_odeiv2_control_free (con);
+  gsl_odeiv2_step_free (step);
+
+  pb = y[0] + y[1];
+  return 2.0 * pb * (1.0 - pb);
+}
+
+/** 
+ * Number of grid points iterated together in the lanes of one vector.
+ */
+#define HH_LANES 4
+
+typedef double hh_vec __attribute__ ((vector_size (HH_LANES * sizeof (double))));
+
+/** 
+ * A point of the parameter grid; het is the final heterozygosity
+ * relative to the initial one.
+ */
+typedef struct {
   double r;
-  /* Threshold used to start and stop iteration. */
-  double eps = 1.0 / (2.0 * (double) N);
+  double h;
+  double s;
+  int N;
+  double het;
+} hh_point;
 
-  /* Genotype frequencies. */
-  double x1 = eps;
-  double x2 = 0;
-  double x3 = 0.5 - x1;
-  double x4 = 0.5;
+/** 
+ * Grid points shared by the threads of get_het_f_batch().
+ */
+typedef struct {
+  hh_point *points;
+  int n_points;
+  int next;
+  double tol;
+  pthread_mutex_t lock;
+} hh_queue;
 
-  double het_i;
-  double het_f;
+/** 
+ * Take the next grid point from the queue.
+ * 
+ * @param queue 
+ * 
+ * @return the index of the point or -1 if the queue is empty.
+ */
+int hh_queue_pop (hh_queue *queue)
+{
+  int i = -1;
+  pthread_mutex_lock (&queue->lock);
+  if (queue->next < queue->n_points)
+    i = queue->next++;
+  pthread_mutex_unlock (&queue->lock);
+  return i;
+}
+
+/** 
+ * Iterate the recursions for the grid points of the queue, HH_LANES
+ * points at a time.  Every point starts with a single A1B1 chromosome
+ * among 2N and the frequency of B1 is 1/2, as in main().  A lane whose
+ * point has reached the threshold 1-1/(2N) stores the result and
+ * takes the next point; lanes without point are parked at the fixed
+ * point x1 = 1.
+ * 
+ * @param arg the queue
+ * 
+ * @return 
+ */
+void * get_het_f_lanes (void *arg)
+{
+  hh_queue *queue = arg;
+  hh_point *pt;
+  int idx[HH_LANES];
+  int l, n_busy;
+  double eps[HH_LANES];
+  double het_i[HH_LANES];
+  hh_vec x1, x2, x3, x4, r, h, s;
+  hh_vec p, q, hs, wb, w1, w3, rd, inv;
+
+  for (l = 0; l < HH_LANES; l++) {
+    idx[l] = -1;
+    x1[l] = 1.0; x2[l] = 0.0; x3[l] = 0.0; x4[l] = 0.0;
+    r[l] = 0.0; h[l] = 0.0; s[l] = 0.0;
+    eps[l] = 0.0;
+    het_i[l] = 1.0;
+  }
+
+  for (;;) {
+    /* Collect finished lanes and refill them. */
+    n_busy = 0;
+    for (l = 0; l < HH_LANES; l++) {
+      while (idx[l] < 0 || x1[l] + x2[l] >= 1.0 - eps[l]) {
+	if (idx[l] >= 0) {
+	  pt = &queue->points[idx[l]];
+	  pt->het = 2.0 * (x1[l] + x3[l]) * (1.0 - x1[l] - x3[l]) / het_i[l];
+	}
+	idx[l] = hh_queue_pop (queue);
+	if (idx[l] < 0) {
+	  x1[l] = 1.0; x2[l] = 0.0; x3[l] = 0.0; x4[l] = 0.0;
+	  break;
+	}
+	pt = &queue->points[idx[l]];
+	eps[l] = 1.0 / (2.0 * pt->N);
+	x1[l] = eps[l];
+	x2[l] = 0.0;
+	x3[l] = 0.5 - eps[l];
+	x4[l] = 0.5;
+	r[l] = pt->r;
+	h[l] = pt->h;
+	s[l] = pt->s;
+	het_i[l] = 2.0 * 0.5 * 0.5;
+      }
+      if (idx[l] >= 0) n_busy++;
+    }
+    if (n_busy == 0)
+      break;
+
+    /* One generation in all lanes; the fitnesses are computed once. */
+    p = x1 + x2;
+    q = 1.0 - p;
+    hs = h * s;
+    wb = 1.0 - 2.0*p*q*hs - q*q*s;
+    w1 = 1.0 - q*hs;
+    w3 = 1.0 - p*hs - q*s;
+    rd = r * (1.0 - hs) * (x1*x4 - x2*x3);
+    inv = 1.0 / wb;
+    w1 = w1 - wb;
+    w3 = w3 - wb;
+    x1 = x1 + (x1*w1 - rd) * inv;
+    x2 = x2 + (x2*w1 + rd) * inv;
+    x3 = x3 + (x3*w3 + rd) * inv;
+    x4 = x4 + (x4*w3 - rd) * inv;
+  }
+  return NULL;
+}
+
+/** 
+ * Solve the continuous-time recursions for the grid points of the
+ * queue with get_het_f_ode(); the initial state is that of
+ * get_het_f_lanes().
+ * 
+ * @param arg the queue
+ * 
+ * @return 
+ */
+void * get_het_f_ode_points (void *arg)
+{
+  hh_queue *queue = arg;
+  hh_point *pt;
+  double eps;
+  int i;
+
+  while ((i = hh_queue_pop (queue)) >= 0) {
+    pt = &queue->points[i];
+    eps = 1.0 / (2.0 * pt->N);
+    pt->het = get_het_f_ode (eps, 0.0, 0.5 - eps,
+			     pt->r, pt->h, pt->s, eps, queue->tol)
+      / (2.0 * 0.5 * 0.5);
+  }
+  return NULL;
+}
+
+/** 
+ * Final heterozygosities of many grid points, distributed over
+ * threads.  If tol is zero, the recursions are iterated in vector
+ * lanes; the results equal those of get_het_f() up to rounding.
+ * Otherwise, the continuous-time approximation is solved with
+ * get_het_f_ode().
+ * 
+ * @param points IN/OUT; the het field is set
+ * @param n_points 
+ * @param n_threads 
+ * @param tol error tolerance of the continuous-time approximation;
+ * 0 iterates the recursions
+ */
+void get_het_f_batch (hh_point *points, int n_points, int n_threads,
+		      double tol)
+{
+  int k;
+  hh_queue queue;
+  pthread_t *threads = malloc (n_threads * sizeof (pthread_t));
+
+  queue.points = points;
+  queue.n_points = n_points;
+  queue.next = 0;
+  queue.tol = tol;
+  pthread_mutex_init (&queue.lock, NULL);
+  for (k = 0; k < n_threads; k++)
+    pthread_create (&threads[k], NULL,
+		    tol > 0 ? get_het_f_ode_points : get_het_f_lanes, &queue);
+  for (k = 0; k < n_threads; k++)
+    pthread_join (threads[k], NULL);
+  pthread_mutex_destroy (&queue.lock);
+  free (threads);
+}
+
+/** 
+ * Parse a range "min:max:n" or a single value.
+ * 
+ * @param arg 
+ * @param min OUT
+ * @param max OUT
+ * @param n OUT
+ */
+void parse_range (const char *arg, double *min, double *max, int *n)
+{
+  int c = sscanf (arg, "%lf:%lf:%d", min, max, n);
+  if (c < 3) *n = 1;
+  if (c < 2) *max = *min;
+  if (*n < 1) *n = 1;
+}
+
+/** 
+ * Value k of n of a range; geometric spacing if geom is nonzero.
+ */
+double range_value (double min, double max, int n, int k, int geom)
+{
+  if (n == 1)
+    return min;
+  if (geom)
+    return min * pow (max / min, (double) k / (n - 1));
+  return min + (max - min) * k / (n - 1);
+}
+
+/** 
+ * Fixation probabilities of A1, diffusion approximation.
+ * 
+ * @param N diploid population size
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
+ * @param u OUT; u[i] is the fixation probability with i copies of
+ * A1; length 2N+1.
+ */
+void fixation_probabilities (int N, double h, double s, double *u)
+{
+  int n = 2*N;
+  int i, k;
+  int n_sub = 16;
+  double y, g, g_prev;
+  double dy = 1.0 / (n * n_sub);
+
+  /* u(p) = \int_0^p G / \int_0^1 G with
+     G(y) = exp(-4Ns((1-h)y + (2h-1)y^2/2)). */
+  u[0] = 0.0;
+  g_prev = 1.0;
+  for (i = 1; i <= n; i++) {
+    u[i] = u[i-1];
+    for (k = 1; k <= n_sub; k++) {
+      y = ((double) (i-1) * n_sub + k) * dy;
+      g = exp (-4.0*N*s * ((1.0-h)*y + (2.0*h-1.0)*y*y/2.0));
+      u[i] += 0.5 * (g + g_prev) * dy;
+      g_prev = g;
+    }
+  }
+  for (i = 1; i <= n; i++)
+    u[i] /= u[n];
+}
+
+/** 
+ * Transition probabilities of the number of A1 chromosomes,
+ * conditioned on fixation of A1.  Row i is stored as cumulative
+ * distribution over the window lo[i], ..., hi[i].
+ */
+typedef struct {
+  int N;
+  double h;
+  double s;
+  int *lo;
+  int *hi;
+  double **cdf;
+} sweep_table;
 
-  het_i = 2.0 * (x1 + x3) * (1 - x1 - x3);
+/** 
+ * Tabulate the conditioned transition probabilities.
+ * 
+ * @param N diploid population size
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
+ * 
+ * @return the table; free it with sweep_table_free().
+ */
+sweep_table * sweep_table_alloc (int N, double h, double s)
+{
+  int n = 2*N;
+  int i, j;
+  double p, p_next, mean, sd, lmax, lp, sum;
+  double *u = malloc ((n+1) * sizeof (double));
+  sweep_table *t = malloc (sizeof (sweep_table));
+
+  t->N = N;
+  t->h = h;
+  t->s = s;
+  t->lo = malloc ((n+1) * sizeof (int));
+  t->hi = malloc ((n+1) * sizeof (int));
+  t->cdf = malloc ((n+1) * sizeof (double *));
+  fixation_probabilities (N, h, s, u);
+
+  for (i = 1; i < n; i++) {
+    p = (double) i / n;
+    p_next = p * w_bar_1 (p, h, s) / w_bar (p, h, s);
+    mean = n * p_next;
+    sd = sqrt (n * p_next * (1.0 - p_next));
+    t->lo[i] = (int) floor (mean - 12.0*sd - 1.0);
+    t->hi[i] = (int) ceil (mean + 12.0*sd + 1.0);
+    if (t->lo[i] < 1) t->lo[i] = 1;
+    if (t->hi[i] > n) t->hi[i] = n;
+    t->cdf[i] = malloc ((t->hi[i] - t->lo[i] + 1) * sizeof (double));
+
+    lmax = lgamma (n + 1.0) - lgamma (mean + 1.0) - lgamma (n - mean + 1.0)
+      + mean * log (p_next) + (n - mean) * log1p (-p_next);
+    sum = 0.0;
+    for (j = t->lo[i]; j <= t->hi[i]; j++) {
+      lp = lgamma (n + 1.0) - lgamma (j + 1.0) - lgamma (n - j + 1.0)
+	+ j * log (p_next) + (n - j) * log1p (-p_next);
+      sum += exp (lp - lmax) * u[j];
+      t->cdf[i][j - t->lo[i]] = sum;
+    }
+    for (j = t->lo[i]; j <= t->hi[i]; j++)
+      t->cdf[i][j - t->lo[i]] /= sum;
+  }
+  free (u);
+  return t;
+}
 
-  fp = fopen("hitchhikingN500.dat", "w");
+/** 
+ * Free a table of transition probabilities.
+ * 
+ * @param t 
+ */
+void sweep_table_free (sweep_table *t)
+{
+  int i;
+  for (i = 1; i < 2*t->N; i++)
+    free (t->cdf[i]);
+  free (t->cdf);
+  free (t->lo);
+  free (t->hi);
+  free (t);
+}
 
-  for (i = 0; i < 100; i++) {
-    r = (double) i / 2000;
-    het_f = get_het_f (x1, x2, x3, x4, r, eps);
-    fprintf(fp, "%f\t%f\n", r/s, het_f / het_i);
+/** 
+ * Sample the number of A1 chromosomes in the next generation,
+ * conditioned on fixation.
+ * 
+ * @param t 
+ * @param i number of A1 chromosomes
+ * @param rng 
+ * 
+ * @return 
+ */
+int sweep_table_pick (const sweep_table *t, int i, const gsl_rng *rng)
+{
+  double v = gsl_rng_uniform (rng);
+  const double *c = t->cdf[i];
+  int a = 0;
+  int b = t->hi[i] - t->lo[i];
+  int m;
+
+  /* Smallest index with c[index] > v. */
+  while (a < b) {
+    m = (a + b) / 2;
+    if (c[m] > v) b = m;
+    else a = m + 1;
+  }
+  return t->lo[i] + a;
+}
+
+/** 
+ * Simulate one sweep conditioned on fixation of A1, starting from a
+ * single A1B1 chromosome; the frequency of B1 is 1/2.
+ * 
+ * @param t 
+ * @param r recombination rates of the neutral loci
+ * @param n_r number of neutral loci
+ * @param het OUT; final heterozygosity at the neutral loci relative
+ * to the initial one
+ * @param n1 work space; length n_r
+ * @param n3 work space; length n_r
+ * @param rng 
+ */
+void sweep (const sweep_table *t, const double *r, int n_r, double *het,
+	    int *n1, int *n3, const gsl_rng *rng)
+{
+  int n = 2*t->N;
+  int i = 1;
+  int j, l;
+  double x1, x2, x3, x4;
+  double y1, y3, pa_next;
+  double pb, het_i;
+
+  /* n1[l], n3[l]: number of A1B1, A2B1 chromosomes. */
+  for (l = 0; l < n_r; l++) {
+    n1[l] = 1;
+    n3[l] = n/2 - 1;
+  }
+  pb = (double) (n/2) / n;
+  het_i = 2.0 * pb * (1.0 - pb);
+
+  while (i < n) {
+    j = sweep_table_pick (t, i, rng);
+    for (l = 0; l < n_r; l++) {
+      x1 = (double) n1[l] / n;
+      x2 = (double) (i - n1[l]) / n;
+      x3 = (double) n3[l] / n;
+      x4 = (double) (n - i - n3[l]) / n;
+      y1 = x1 + delta_x1 (x1, x2, x3, x4, r[l], t->h, t->s);
+      y3 = x3 + delta_x3 (x1, x2, x3, x4, r[l], t->h, t->s);
+      pa_next = (x1 + x2) * w_bar_1 (x1 + x2, t->h, t->s)
+	/ w_bar (x1 + x2, t->h, t->s);
+      n1[l] = gsl_ran_binomial (rng, fmin (fmax (y1 / pa_next, 0.0), 1.0), j);
+      n3[l] = (pa_next < 1.0) ?
+	gsl_ran_binomial (rng, fmin (fmax (y3 / (1.0 - pa_next), 0.0), 1.0),
+			  n - j) : 0;
+    }
+    i = j;
+  }
+
+  for (l = 0; l < n_r; l++) {
+    pb = (double) (n1[l] + n3[l]) / n;
+    het[l] = 2.0 * pb * (1.0 - pb) / het_i;
+  }
+}
+
+/** 
+ * Work of one thread of sweep_replicates().
+ */
+typedef struct {
+  const sweep_table *t;
+  const double *r;
+  int n_r;
+  int first;
+  int last;
+  double *het;
+  unsigned long seed;
+} sweep_task;
+
+void * sweep_thread (void *arg)
+{
+  sweep_task *task = arg;
+  int k;
+  int *n1 = malloc (task->n_r * sizeof (int));
+  int *n3 = malloc (task->n_r * sizeof (int));
+  gsl_rng *rng = gsl_rng_alloc (gsl_rng_mt19937);
+
+  gsl_rng_set (rng, task->seed);
+  for (k = task->first; k < task->last; k++)
+    sweep (task->t, task->r, task->n_r, task->het + (size_t) k * task->n_r,
+	   n1, n3, rng);
+  gsl_rng_free (rng);
+  free (n1);
+  free (n3);
+  return NULL;
+}
+
+/** 
+ * Simulate replicate sweeps conditioned on fixation, distributed
+ * over threads.
+ * 
+ * @param N diploid population size
+ * @param h heterozygous coefficient
+ * @param s selection coefficient
+ * @param r recombination rates of the neutral loci
+ * @param n_r number of neutral loci
+ * @param n_reps number of sweeps
+ * @param n_threads 
+ * @param seed thread k uses the seed seed+k
+ * @param het OUT; het[k*n_r+l] is the relative heterozygosity of
+ * neutral locus l after sweep k
+ */
+void sweep_replicates (int N, double h, double s, const double *r, int n_r,
+		       int n_reps, int n_threads, unsigned long seed,
+		       double *het)
+{
+  int k;
+  sweep_table *t = sweep_table_alloc (N, h, s);
+  pthread_t *threads = malloc (n_threads * sizeof (pthread_t));
+  sweep_task *tasks = malloc (n_threads * sizeof (sweep_task));
+
+  for (k = 0; k < n_threads; k++) {
+    tasks[k].t = t;
+    tasks[k].r = r;
+    tasks[k].n_r = n_r;
+    tasks[k].first = (int) ((long) n_reps * k / n_threads);
+    tasks[k].last = (int) ((long) n_reps * (k+1) / n_threads);
+    tasks[k].het = het;
+    tasks[k].seed = seed + k;
+    pthread_create (&threads[k], NULL, sweep_thread, &tasks[k]);
+  }
+  for (k = 0; k < n_threads; k++)
+    pthread_join (threads[k], NULL);
+
+  free (tasks);
+  free (threads);
+  sweep_table_free (t);
+}
+
+int compare_double (const void *a, const void *b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+  int i, j, k, c;
+  FILE *fp;
+  char fn[64];
+
+  /* Diploid population sizes. */
+  double N_min = 500, N_max = 500;
+  int n_N = 1;
+  /* Heterozygous coefficients. */
+  double h_min = 0.5, h_max = 0.5;
+  int n_h = 1;
+  /* Selection coefficients. */
+  double s_min = 0.1, s_max = 0.1;
+  int n_s = 1;
+  /* Recombination rates; r/s = i/200 for i < n_r. */
+  int n_r = 100;
+  double *rs;
+  /* Grid of the deterministic recursions. */
+  hh_point *points;
+  int n_points;
+  /* Error tolerance of the continuous-time approximation; 0 iterates
+     the recursions generation by generation. */
+  double tol = 0.0;
+  int N;
+  double h, s;
+
+  /* Stochastic sweeps; off unless set with -r. */
+  int n_reps = 0;
+  int n_threads = 1;
+  unsigned long seed = 0;
+  double *het, *col;
+  double mean;
+
+  while ((c = getopt (argc, argv, "N:H:S:R:o:r:t:s:")) != -1)
+    switch (c) {
+    case 'N':
+      /* Population sizes "min:max:n", geometric. */
+      parse_range (optarg, &N_min, &N_max, &n_N);
+      break;
+    case 'H':
+      /* Heterozygous coefficients "min:max:n", linear. */
+      parse_range (optarg, &h_min, &h_max, &n_h);
+      break;
+    case 'S':
+      /* Selection coefficients "min:max:n", geometric. */
+      parse_range (optarg, &s_min, &s_max, &n_s);
+      break;
+    case 'R':
+      n_r = atoi (optarg);
+      break;
+    case 'o':
+      /* Continuous time with error tolerance tol. */
+      tol = atof (optarg);
+      break;
+    case 'r':
+      /* Number of stochastic sweeps; 0 disables them. */
+      n_reps = atoi (optarg);
+      break;
+    case 't':
+      n_threads = atoi (optarg);
+      break;
+    case 's':
+      seed = atol (optarg);
+      break;
+    default:
+      fprintf (stderr, "Usage: %s [-N min:max:n] [-H min:max:n]"
+	       " [-S min:max:n] [-R recombination rates] [-o tolerance]"
+	       " [-r sweeps] [-t threads] [-s seed]\n", argv[0]);
+      return 1;
+    }
+  if (n_threads < 1) n_threads = 1;
+  if (n_r < 1) n_r = 1;
+  if (N_min < 1.0 || N_max < 1.0) {
+    fprintf (stderr, "Population sizes have to be at least one.\n");
+    return 1;
+  }
+  /* A1 does not fix without positive selection. */
+  if (s_min <= 0.0 || s_max <= 0.0) {
+    fprintf (stderr, "Selection coefficients have to be positive.\n");
+    return 1;
+  }
+  if (h_min < 0.0 || h_min > 1.0 || h_max < 0.0 || h_max > 1.0) {
+    fprintf (stderr, "Heterozygous coefficients have to be in [0,1].\n");
+    return 1;
+  }
+
+  /* Deterministic recursions over the grid (N, h, s, r). */
+  n_points = n_N * n_h * n_s * n_r;
+  points = malloc ((size_t) n_points * sizeof (hh_point));
+  k = 0;
+  for (i = 0; i < n_N * n_h * n_s; i++)
+    for (j = 0; j < n_r; j++) {
+      points[k].N = (int) round (range_value (N_min, N_max, n_N,
+					       i / (n_h * n_s), 1));
+      points[k].h = range_value (h_min, h_max, n_h, (i / n_s) % n_h, 0);
+      points[k].s = range_value (s_min, s_max, n_s, i % n_s, 1);
+      points[k].r = points[k].s * j / 200.0;
+      k++;
+    }
+  get_het_f_batch (points, n_points, n_threads, tol);
+
+  if (n_points == n_r) {
+    snprintf (fn, sizeof (fn), "hitchhikingN%d.dat", points[0].N);
+    fp = fopen (fn, "w");
+    for (k = 0; k < n_points; k++)
+      fprintf(fp, "%f\t%f\n", points[k].r / points[k].s, points[k].het);
+  }
+  else {
+    /* N, h, s, r/s, het_f / het_i. */
+    fp = fopen ("hitchhiking_map.dat", "w");
+    for (k = 0; k < n_points; k++)
+      fprintf(fp, "%d\t%f\t%g\t%f\t%f\n", points[k].N, points[k].h,
+	      points[k].s, points[k].r / points[k].s, points[k].het);
+  }
+  fclose (fp);
+
+  N = points[0].N;
+  h = points[0].h;
+  s = points[0].s;
+  free (points);
+  if (n_reps <= 0)
+    return 0;
+
+  /* Stochastic sweeps at the first grid point of N, h and s.  All
+     recombination rates share the trajectories of A1. */
+  rs = malloc (n_r * sizeof (double));
+  for (i = 0; i < n_r; i++)
+    rs[i] = s * i / 200.0;
+  het = malloc ((size_t) n_reps * n_r * sizeof (double));
+  col = malloc (n_reps * sizeof (double));
+  sweep_replicates (N, h, s, rs, n_r, n_reps, n_threads, seed, het);
+
+  /* r/s, mean, 5%, 50% and 95% quantiles of het_f / het_i. */
+  snprintf (fn, sizeof (fn), "hitchhikingN%d_stochastic.dat", N);
+  fp = fopen (fn, "w");
+  for (i = 0; i < n_r; i++) {
+    mean = 0.0;
+    for (k = 0; k < n_reps; k++) {
+      col[k] = het[(size_t) k * n_r + i];
+      mean += col[k];
+    }
+    mean /= n_reps;
+    qsort (col, n_reps, sizeof (double), compare_double);
+    fprintf(fp, "%f\t%f\t%f\t%f\t%f\n", rs[i]/s, mean,
+	    col[(int) (0.05 * (n_reps - 1))],
+	    col[(int) (0.50 * (n_reps - 1))],
+	    col[(int) (0.95 * (n_reps - 1))]);
   }
+  fclose (fp);
 
+  free (col);
+  free (het);
+  free (rs);
   return 0;
 }
@@ -1,7 +1,9 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
 #include "ran_generator.h"
+#include "ctmc.h"
 
 /**
  * @file   hopping_flees.cpp
@@ -36,6 +38,12 @@
  * We can see, that the empirical simulation fits the analytical results very well:
  *
  * \image html hopping_flees.png
+ *
+ * Each replicate is one trajectory of the chain that is sampled at
+ * all time points in a single pass (see CTMC::run_grid()); the
+ * samples at different time points of one replicate are therefore
+ * correlated, but each time point still sees n_reps independent
+ * trajectories.
  * 
  */
 
@@ -54,66 +62,6 @@ double t_max              = 1;
 unsigned int n_time_steps = 1000;
 unsigned int n_reps       = 10000;
 
-class ContChain
-{
-public:
-    ContChain (int s_init, double t_init, int d_init, double * qm_init);
-    ~ContChain ();
-    int s;
-    double t;
-    int d;
-    double * qm;
-};
-
-ContChain::ContChain (int s_init, double t_init, int d_init, double * qm_init)
-{
-    s = s_init;
-    t = t_init;
-    d = d_init;
-    qm = qm_init;
-}
-
-ContChain::~ContChain ()
-{
-
-}
-
-bool jump(ContChain * ch, double t, RanGen * rg)
-{
-    int s = ch->s;
-    int d = ch->d;
-    double q = -ch->qm[s*d + s];
-    // std::cout << "q=" << q << std::endl;
-    double dt = rg->pick_exponential(1.0/q);
-    // std::cout << "dt=" << dt << std::endl;
-    if (ch->t + dt > t) {
-        ch->t = t;
-        // std::cout << "Stop at " << t << std::endl;
-        return false;
-    }
-    else {
-        // FIXME: Only works for this specific problem at the moment.
-        gsl_vector * v = gsl_vector_alloc(2);
-        gsl_vector_set(v,0,la);
-        gsl_vector_set(v,1,mu);
-        // v[] = {la, mu};
-        int ds = rg->vector_weighted_pick(v, 2);
-        gsl_vector_free(v);
-        if (ds == 0) ds = -1;
-        int s_prime = s + ds;
-        if (s_prime < 0) s_prime = 2;
-        if (s_prime > 2) s_prime = 0;
-        ch->s  = s_prime;
-        ch->t += dt;
-        return true;
-    }
-}
-
-void evolve_chain(ContChain * ch, double t, RanGen * rg)
-{
-    while (jump(ch,t,rg));
-}
-
 double hopping_flees_prob (double la, double mu, double t) {
     double e = exp (-3.0*(la+mu)*t/2.0);
     double c = cos (sqrt(3.0)*(la-mu)*t/2.0);
@@ -122,30 +70,34 @@ double hopping_flees_prob (double la, double mu, double t) {
 
 int main()
 {
-    RanGen rg;
+    gsl_matrix_view qm = gsl_matrix_view_array(q_matrix, n_states, n_states);
+    CTMC chain(&qm.matrix, n_states, false, 0);
+
+    std::vector<double> times(n_time_steps);
+    for (unsigned int i = 0; i < n_time_steps; i++)
+        times[i] = (double) i * t_max / n_time_steps;
+    std::vector<unsigned int> hits(n_time_steps, 0);
+    std::vector<state> states;
+    for (unsigned int r = 0; r < n_reps; r++) {
+        chain.reset(s_init);
+        chain.run_grid(times, states);
+        for (unsigned int i = 0; i < n_time_steps; i++)
+            if (states[i] == 0) hits[i]++;
+    }
 
     std::cout << std::setiosflags(std::ios::fixed) << std::setprecision(3);
     std::cout << std::setw(7) << "t";
     std::cout << std::setw(7) << "p_emp";
     std::cout << std::setw(7) << "p_exa" << std::endl;
 
-    unsigned int hits;
     double p_emp;
     double p_exa;
 
     for (unsigned int i = 0; i < n_time_steps; i++) {
-        hits = 0;
-        double t = (double) i * t_max / n_time_steps;
-        for (unsigned int r = 0; r < n_reps; r++) {
-            ContChain * ch = new ContChain(s_init, 0.0, n_states, q_matrix);
-            evolve_chain (ch, t, &rg);
-            if (ch->s == 0) hits++;
-            delete ch;
-        }
-        p_emp = (double) hits/n_reps;
-        p_exa = hopping_flees_prob(la, mu, t);
+        p_emp = (double) hits[i]/n_reps;
+        p_exa = hopping_flees_prob(la, mu, times[i]);
 
-        std::cout << std::setw(7) << t;
+        std::cout << std::setw(7) << times[i];
         std::cout << std::setw(7) << p_emp;
         std::cout << std::setw(7) << p_exa << std::endl;
     }
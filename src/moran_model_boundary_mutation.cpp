@@ -2,6 +2,7 @@
 #include <iostream>
 #include <string>
 #include "ctmc.h"
+#include "bdmc.h"
 #include "tools.h"
 #include "getopt.h"
 #include <unistd.h>
@@ -10,6 +11,15 @@
 
 template double * new_zeroes<double>(unsigned int);
 
+// Set the mutations from the boundaries; only the rows 0 and n
+// depend on the mutation rate.
+void moran_boundary_mut_set_mu (gsl_matrix * m, size_t n, double mu) {
+    gsl_matrix_set(m, 0, 0, -mu);
+    gsl_matrix_set(m, 0, 1, mu);
+    gsl_matrix_set(m, n, n, -mu);
+    gsl_matrix_set(m, n, n-1, mu);
+}
+
 gsl_matrix * moran_boundary_mut_matrix (size_t n, double mu) {
     gsl_matrix * m = gsl_matrix_alloc(n+1, n+1);
     gsl_matrix_set_zero(m);
@@ -22,29 +32,42 @@ gsl_matrix * moran_boundary_mut_matrix (size_t n, double mu) {
         gsl_matrix_set(m, i, i+1, (double) i*(n-i)/n);
     }
 
-    // Set the mutations from the boundaries.
-    gsl_matrix_set(m, 0, 0, -mu);
-    gsl_matrix_set(m, 0, 1, mu);
-    gsl_matrix_set(m, n, n, -mu);
-    gsl_matrix_set(m, n, n-1, mu);
+    moran_boundary_mut_set_mu(m, n, mu);
 
     return m;
 }
 
+// The same chain stored as birth-death rates only; O(n) memory.
+void moran_boundary_mut_rates (size_t n, double mu,
+                               double * up, double * down) {
+    size_t i;
+    for (i = 1; i < n; i++) {
+        up[i] = (double) i*(n-i)/n;
+        down[i] = (double) i*(n-i)/n;
+    }
+    up[0] = mu;
+    down[0] = 0;
+    up[n] = 0;
+    down[n] = mu;
+}
+
 int main(int argc, char *argv[])
 {
     // Option parsing.
     unsigned int ne = 10;
     int tm = 1e6;
     double mu = 1e-1;
+    double mu_max = 1e-1;
+    unsigned int n_mu = 1;
     int log_l = 1;
     char * out_fn = NULL;
     bool seed = false;
+    bool birth_death = false;
     int c;
 
     opterr = 0;
 
-    while ((c = getopt (argc, argv, "n:t:m:f:l:s")) != -1)
+    while ((c = getopt (argc, argv, "n:t:m:M:k:f:l:sb")) != -1)
         switch (c)
             {
             case 'n':
@@ -59,6 +82,14 @@ int main(int argc, char *argv[])
                 // Mutation rate.
                 mu = atof(optarg);
                 break;
+            case 'M':
+                // Largest mutation rate of a sweep.
+                mu_max = atof(optarg);
+                break;
+            case 'k':
+                // Number of mutation rates of a sweep.
+                n_mu = atoi(optarg);
+                break;
             case 'f':
                 // Print output to file.
                 out_fn = optarg;
@@ -71,8 +102,13 @@ int main(int argc, char *argv[])
                 // Set seed randomly.
                 seed = true;
                 break;
+            case 'b':
+                // Use the birth-death chain.
+                birth_death = true;
+                break;
             case '?':
-                if (optopt == 'n' || optopt == 't' || optopt == 'm') {
+                if (optopt == 'n' || optopt == 't' || optopt == 'm' ||
+                    optopt == 'M' || optopt == 'k') {
                     std::cerr << "Option -" << optopt;
                     std::cerr << " requires an argument." << std::endl;
                 }
@@ -98,6 +134,51 @@ int main(int argc, char *argv[])
         log_out << argv[count] << " ";
     log_out << std::endl;
 
+    if (birth_death) {
+        log_out << "Setup birth-death chain." << std::endl;
+        double * up = new double[ne+1];
+        double * down = new double[ne+1];
+        double * pi = new double[ne+1];
+        moran_boundary_mut_rates(ne, mu, up, down);
+        BDChain chain(up, down, ne+1);
+        if (seed) {
+            unsigned long int s;
+            log_out << "Bytes set:";
+            log_out <<
+                syscall(SYS_getrandom, &s, sizeof(unsigned long int), 0);
+            log_out << std::endl;
+            log_out << "Seed is: " << s << "." << std::endl;
+            chain.rg->set_seed(s);
+        }
+        // Start in the stationary distribution; no burn in is needed.
+        chain.set_state_stationary();
+        for (unsigned int i = 0; i < n_mu; i++) {
+            double mu_i = mu;
+            if (n_mu > 1) mu_i += (mu_max - mu) * i / (n_mu - 1);
+            if (i > 0) {
+                chain.set_rates(0, mu_i, 0);
+                chain.set_rates(ne, 0, mu_i);
+                chain.reset_analysis();
+            }
+            log_out << "Mutation rate: " << mu_i << std::endl;
+
+            std::cout << "Run chain." << std::endl;
+            chain.run(tm);
+
+            std::cout << "Print output." << std::endl;
+            chain.print_invariant_distribution(log_out);
+            chain.stationary_distribution(pi);
+            log_out << "The exact stationary distribution is:" << std::endl;
+            for (unsigned int j = 0; j <= ne; j++)
+                log_out << std::setw(10) << pi[j] << std::endl;
+        }
+        delete[] up;
+        delete[] down;
+        delete[] pi;
+        log_out.close();
+        return 0;
+    }
+
     log_out << "Setup chain." << std::endl;
     gsl_matrix * m =
         moran_boundary_mut_matrix(ne, mu);
@@ -116,14 +197,31 @@ int main(int argc, char *argv[])
     chain.set_log_level(log_l);
     // chain.print_info(std::cout);
 
-    std::cout << "Run chain." << std::endl;
-    chain.run(tm);
+    // Sweep over the mutation rates.  The matrix is assembled once;
+    // for each new mutation rate only the boundary rows are patched
+    // and the chain continues from its previous state.
+    std::vector<state> boundary_rows;
+    boundary_rows.push_back(0);
+    boundary_rows.push_back(ne);
+    for (unsigned int i = 0; i < n_mu; i++) {
+        double mu_i = mu;
+        if (n_mu > 1) mu_i += (mu_max - mu) * i / (n_mu - 1);
+        if (i > 0) {
+            moran_boundary_mut_set_mu(m, ne, mu_i);
+            chain.update_rows(boundary_rows);
+            chain.reset_analysis();
+        }
+        log_out << "Mutation rate: " << mu_i << std::endl;
+
+        std::cout << "Run chain." << std::endl;
+        chain.run(tm);
 
-    std::cout << "Print output." << std::endl;
-    // chain.print_direct_hitting_times(std::cout);
-    chain.print_hitting_times(log_out);
-    // chain.print_direct_number_jumps(std::cout);
-    chain.print_invariant_distribution(log_out);
+        std::cout << "Print output." << std::endl;
+        // chain.print_direct_hitting_times(std::cout);
+        // chain.print_hitting_times(log_out);
+        // chain.print_direct_number_jumps(std::cout);
+        chain.print_invariant_distribution(log_out);
+    }
 
     gsl_matrix_free(m);
     log_out.close();
@@ -0,0 +1,160 @@
+/**
+ * @file   perfect_sampling.cpp
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 23:59:41 2026
+ *
+ * @brief  Exact draws from the stationary distribution of monotone
+ * chains with coupling from the past.
+ *
+ * Available chains (-c):
+ * - ehrenfest: N particles in a divided box (see ehrenfest_mcmc.cpp),
+ *   as a lazy birth-death chain; the stationary distribution is
+ *   binomial with p=1/2.
+ * - moran: the Moran model with boundary mutation (see
+ *   moran_model_boundary_mutation.cpp).
+ * - wf: the Wright-Fisher model with boundary mutation (see
+ *   wright_fisher_boundary_mutation.cpp); the mutation rate has to be
+ *   at most one.
+ *
+ * The draws are independent and need no burn in (see cftp.h).  The
+ * frequency of each state among the draws is printed next to the
+ * exact stationary distribution, which is computed by detailed
+ * balance for the birth-death chains and with a high power of the
+ * transition probability matrix for the Wright-Fisher model.
+ *
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_randist.h>
+#include "cftp.h"
+#include "bdmc.h"
+#include "dtmc.h"
+
+std::string chain = "ehrenfest";  /**< The chain. */
+unsigned int n = 20;            /**< Number of particles or population size. */
+double mu = 0.1;                /**< Mutation rate. */
+unsigned long n_samples = 100000; /**< Number of draws. */
+unsigned int n_threads = 1;     /**< Number of threads. */
+unsigned long seed = 1;         /**< Seed. */
+
+int main(int argc, char *argv[])
+{
+    int c;
+    while ((c = getopt (argc, argv, "c:n:m:r:t:s:")) != -1)
+        switch (c)
+            {
+            case 'c':
+                chain = optarg;
+                break;
+            case 'n':
+                n = atoi(optarg);
+                break;
+            case 'm':
+                mu = atof(optarg);
+                break;
+            case 'r':
+                n_samples = atol(optarg);
+                break;
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 's':
+                seed = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-c ehrenfest|moran|wf] [-n size]"
+                          << " [-m mutation rate] [-r samples]"
+                          << " [-t threads] [-s seed]" << std::endl;
+                return 1;
+            }
+    if (n < 1) {
+        std::cerr << "The size has to be at least one." << std::endl;
+        return 1;
+    }
+    // Without mutation, the boundaries are absorbing and the chains
+    // never meet.
+    if (chain != "ehrenfest" && mu <= 0) {
+        std::cerr << "The mutation rate has to be positive." << std::endl;
+        return 1;
+    }
+    if (chain == "wf" && mu > 1) {
+        std::cerr << "The Wright-Fisher model is only monotone for a"
+                  << " mutation rate of at most one." << std::endl;
+        return 1;
+    }
+
+    size_t ns = n + 1;
+    std::vector<double> pi(ns);
+    MonotoneUpdate * f = NULL;
+    if (chain == "ehrenfest" || chain == "moran") {
+        std::vector<double> up(ns, 0), down(ns, 0);
+        for (size_t i = 0; i < ns; i++) {
+            if (chain == "ehrenfest") {
+                up[i] = n - i;
+                down[i] = i;
+            }
+            else if (i > 0 && i < n)
+                up[i] = down[i] = (double) i * (n - i) / n;
+        }
+        if (chain == "moran") {
+            up[0] = mu;
+            down[n] = mu;
+        }
+        f = new BirthDeathUpdate(&up[0], &down[0], ns);
+        BDChain bd(&up[0], &down[0], ns);
+        bd.stationary_distribution(&pi[0]);
+    }
+    else if (chain == "wf") {
+        gsl_matrix * p = gsl_matrix_alloc(ns, ns);
+        for (size_t i = 0; i < ns; i++) {
+            double q = (double) i / n;
+            if (i == 0) q = mu / n;
+            if (i == n) q = 1 - mu / n;
+            for (size_t j = 0; j < ns; j++)
+                gsl_matrix_set(p, i, j, gsl_ran_binomial_pdf(j, q, n));
+        }
+        f = new InverseCdfUpdate(p);
+        DTMC dtmc(p);
+        pi.assign(ns, 0);
+        pi[0] = 1;
+        dtmc.distribution(1ul << 40, pi);
+        gsl_matrix_free(p);
+    }
+    else {
+        std::cerr << "Unknown chain " << chain << "." << std::endl;
+        return 1;
+    }
+
+    std::vector<state> samples;
+    std::vector<unsigned long> t_back;
+    cftp_samples(*f, n_samples, n_threads, seed, samples, t_back);
+    delete f;
+
+    std::vector<unsigned long> counts(ns, 0);
+    double mean_t = 0;
+    unsigned long max_t = 0;
+    for (unsigned long k = 0; k < n_samples; k++) {
+        counts[samples[k]]++;
+        mean_t += (double) t_back[k] / n_samples;
+        if (t_back[k] > max_t) max_t = t_back[k];
+    }
+    double tv = 0;
+    std::cout << "# state, frequency, stationary probability" << std::endl;
+    for (size_t i = 0; i < ns; i++) {
+        double freq = (double) counts[i] / n_samples;
+        tv += std::fabs(freq - pi[i]) / 2;
+        std::cout << i << " " << freq << " " << pi[i] << std::endl;
+    }
+    std::cout << "# Total variation distance: " << tv << std::endl;
+    std::cout << "# Steps back in time: mean " << mean_t << ", maximum "
+              << max_t << std::endl;
+
+    return 0;
+}
@@ -29,106 +29,290 @@
  *  example of a Markov chain that is easy to simulate but difficult
  *  to analyze in terms of its transition matrix.
  *
+ *  By default, the steps are performed one after another.  With more
+ *  than one thread, the torus is cut into tiles that are updated in
+ *  parallel (see stepping_stone.h); then, the number of steps is
+ *  rounded to full time windows.
+ *
+ *  With -k, only the steps that change a color are simulated (kinetic
+ *  Monte Carlo); the run stops early when one color has taken over,
+ *  and the number of steps is printed.
+ *
+ *  With -d, the model is not run forward.  Instead, lineages are
+ *  traced backward with coalescing random walks (see
+ *  SteppingStoneDual) for pairs of squares at distances up to d in
+ *  the same row, and the probabilities that a pair has a common
+ *  ancestor and that it has the same color are printed.  With -c, all
+ *  squares are traced back until they have a single ancestor; this
+ *  is the time to consensus when every square starts with its own
+ *  color.
+ *
+ *  With -C, the squares get k colors instead of two.  The model can
+ *  also run on other lattices (see lattice.h): -g selects the torus
+ *  with a neighbor table, the hexagonal torus or the cubic torus (side
+ *  length l), -e reads an arbitrary graph from an edge list, and -m
+ *  numbers the sites along the Morton curve.
+ *
+ *  With -i, the run is divided into intervals of the given number of
+ *  steps; after each interval, the fraction of each color and the
+ *  interface density (the fraction of edges between different colors)
+ *  are printed, and with -u also the number of clusters and the size
+ *  of the largest one.  These observables are updated with each step,
+ *  so that sampling them is cheap.  With -o, a binary snapshot of the
+ *  lattice is written to a file at the start and after each interval
+ *  (see snapshot.h).
+ *
+ *  With -R, 64 replicates with random initial colors are run at once
+ *  in the bits of one word per square, and the number of squares with
+ *  color 1 is printed for each replicate.
+ *
  */
 
 #include <iostream>
-#include <stdexcept>
-#include <gsl/gsl_rng.h>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <unistd.h>
+#include "stepping_stone.h"
+#include "snapshot.h"
 
 // User interface.
-int l = 30;                    /**< Array length; there are n*n squares. */
+unsigned int l = 30;           /**< Array length; there are l*l squares. */
 
 // Markov chain settings.
-int n_steps = 100000;
-
-void
-print_field (char * field, int n)
-{
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n ; j++) {
-            if (field[i*n+j] == 1) std::cout << "+";
-            else if (field[i*n+j] == 0) std::cout << " ";
-            else throw std::runtime_error("Unknown field value.\n");
-        }
-        std::cout << std::endl;
-    }
-}
+unsigned long n_steps = 100000;
 
-void jump(char * field, int n, const gsl_rng * r)
-{
-    int nn = n*n;
-    volatile int pick = gsl_rng_uniform_int (r, nn);
-    volatile int direction = gsl_rng_uniform_int (r, 8);
+// Parallel settings.
+unsigned int n_threads = 1;     /**< Number of threads. */
+double window = 0.1;            /**< Time window in sweeps. */
+unsigned int tile = 256;        /**< Side length of tiles. */
 
-    volatile int i = (int) pick / n;
-    volatile int j = pick % n;
+unsigned long seed = 1;         /**< Seed. */
+bool quiet = false;             /**< Do not print the field. */
+bool replicates = false;        /**< Run 64 bit-sliced replicates. */
+bool kmc = false;               /**< Rejection-free kinetic Monte Carlo. */
+unsigned int max_dist = 0;      /**< Dual: largest distance of pairs. */
+unsigned long n_samples = 10000; /**< Dual: pairs per distance. */
+bool consensus = false;         /**< Dual: time to consensus. */
 
-    switch(direction) {
-    case 0 :
-        i -= 1;
-        j -= 1;
-        break;
-    case 1 :
-        j -= 1;
-        break;
-    case 2 :
-        i += 1;
-        j -= 1;
-        break;
-    case 3 :
-        i += 1;
-        break;
-    case 4 :
-        i += 1;
-        j += 1;
-        break;
-    case 5 :
-        j += 1;
-        break;
-    case 6 :
-        i -= 1;
-        j += 1;
-        break;
-    case 7 :
-        i -= 1;
-        break;
-    default :
-        throw std::runtime_error("Direction not known.");
-    }
-    if (i < 0) i += n;
-    else if (i >= n) i -= n;
+// Lattice settings.
+unsigned int n_colors = 2;      /**< Number of colors. */
+const char * topology = NULL;   /**< torus, hex or cubic. */
+const char * edge_file = NULL;  /**< Graph from an edge list. */
+bool morton = false;            /**< Number sites along the Morton curve. */
 
-    if (j < 0) j += n;
-    else if (j >=n ) j -= n;
+// Monitoring.
+unsigned long interval = 0;     /**< Steps between samples; 0 for none. */
+bool track = false;             /**< Track clusters. */
+const char * snapshot_file = NULL; /**< Binary snapshots. */
 
-    field[pick] = field[i*n+j];
+/**
+ * Print the fraction of each color, the interface density and the
+ * clusters.
+ *
+ */
+void print_sample(const SteppingStone & ss, unsigned long step) {
+    unsigned long n_sites = ss.get_n_sites();
+    std::cout << step << " " << (double) step / n_sites;
+    for (unsigned int k = 1; k < n_colors; k++)
+        std::cout << " " << (double) ss.count(k) / n_sites;
+    std::cout << " " << (double) ss.get_interface() / ss.get_n_edges();
+    if (track)
+        std::cout << " " << ss.get_n_clusters() << " "
+                  << ss.get_largest_cluster();
+    std::cout << std::endl;
 }
 
 int
-main (void)
+main (int argc, char *argv[])
 {
-    const gsl_rng_type * t;
-    gsl_rng * r;
-
-    gsl_rng_env_setup();
-    t = gsl_rng_default;
-    r = gsl_rng_alloc (t);
-    gsl_rng_set (r, 1);
+    int c;
+    while ((c = getopt (argc, argv, "l:n:t:w:b:s:qRkd:r:cC:g:e:mi:uo:")) != -1)
+        switch (c)
+            {
+            case 'l':
+                l = atoi(optarg);
+                break;
+            case 'n':
+                n_steps = atol(optarg);
+                break;
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 'w':
+                window = atof(optarg);
+                break;
+            case 'b':
+                tile = atoi(optarg);
+                break;
+            case 's':
+                seed = atol(optarg);
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'R':
+                replicates = true;
+                break;
+            case 'k':
+                kmc = true;
+                break;
+            case 'd':
+                max_dist = atoi(optarg);
+                break;
+            case 'r':
+                n_samples = atol(optarg);
+                break;
+            case 'c':
+                consensus = true;
+                break;
+            case 'C':
+                n_colors = atoi(optarg);
+                break;
+            case 'g':
+                topology = optarg;
+                break;
+            case 'e':
+                edge_file = optarg;
+                break;
+            case 'm':
+                morton = true;
+                break;
+            case 'i':
+                interval = atol(optarg);
+                break;
+            case 'u':
+                track = true;
+                break;
+            case 'o':
+                snapshot_file = optarg;
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-l side length] [-n steps] [-t threads]"
+                          << " [-w window] [-b tile size] [-s seed] [-q] [-R] [-k]"
+                          << " [-d distance] [-r samples] [-c]"
+                          << " [-C colors] [-g torus|hex|cubic]"
+                          << " [-e edge list] [-m]"
+                          << " [-i interval] [-u] [-o snapshot file]"
+                          << std::endl;
+                return 1;
+            }
 
-    int ll = l*l;
-    char field[ll];
-    for (int i = 0; i < ll; i++) {
-        field[i] = i % 2;
+    double time = (double) n_steps / ((double) l * l);
+    if (max_dist > 0) {
+        std::vector<double> coalesced, same_color;
+        stepping_stone_dual_pairs(l, time, max_dist, n_samples, n_threads,
+                                  seed, coalesced, same_color);
+        std::cout << "# distance, common ancestor, same color" << std::endl;
+        for (unsigned int d = 1; d < coalesced.size(); d++)
+            std::cout << d << " " << coalesced[d] << " " << same_color[d]
+                      << std::endl;
+        return 0;
+    }
+    if (consensus) {
+        RanGen rg;
+        rg.set_seed(seed);
+        SteppingStoneDual dual(l);
+        std::vector<unsigned long> sites((unsigned long) l * l), ancestors;
+        std::vector<unsigned int> lineage;
+        for (unsigned long x = 0; x < sites.size(); x++) sites[x] = x;
+        double t = dual.trace(sites, HUGE_VAL, rg, ancestors, lineage);
+        std::cout << "Time to consensus: " << t << " sweeps ("
+                  << t * l * l << " steps)" << std::endl;
+        return 0;
     }
 
-    for (int i = 0; i < n_steps; i++) {
-        jump (field, l, r);
+    if (replicates) {
+        SteppingStone64 ss(l);
+        ss.rg->set_seed(seed);
+        ss.randomize();
+        ss.run(n_steps);
+        std::vector<unsigned long> counts;
+        ss.count(counts);
+        for (unsigned int k = 0; k < 64; k++)
+            std::cout << k << " " << counts[k] << std::endl;
+        return 0;
     }
 
+    Lattice * lat = NULL;
+    if (edge_file)
+        lat = new Lattice(edge_file);
+    else if (topology || morton) {
+        lattice_type type = LATTICE_TORUS;
+        if (topology && std::string(topology) == "hex")
+            type = LATTICE_HEXAGONAL;
+        else if (topology && std::string(topology) == "cubic")
+            type = LATTICE_CUBIC;
+        else if (topology && std::string(topology) != "torus") {
+            std::cerr << "Unknown topology " << topology << "." << std::endl;
+            return 1;
+        }
+        lat = new Lattice(type, l, morton);
+    }
+    SteppingStone * ss = lat ? new SteppingStone(*lat, n_colors)
+        : new SteppingStone(l, n_colors);
+    ss->rg->set_seed(seed);
+    unsigned long n_sites = ss->get_n_sites();
+    if (track) ss->track_clusters();
+    SnapshotWriter * snapshots = NULL;
+    if (snapshot_file) {
+        // Write the sites of regular lattices in row major order.
+        std::vector<uint32_t> order;
+        if (lat && lat->get_side() > 0)
+            for (unsigned long r = 0; r < n_sites; r++)
+                order.push_back(lat->grid_site(r));
+        snapshots = new SnapshotWriter(snapshot_file, n_sites, n_colors,
+                                       lat ? lat->get_side() : l,
+                                       lat ? lat->get_type() : LATTICE_TORUS,
+                                       order);
+    }
 
-    print_field (field, l);
+    if (interval > 0) {
+        std::cout << "# step, time, fraction of colors 1 to "
+                  << n_colors - 1 << ", interface density";
+        if (track) std::cout << ", clusters, largest cluster";
+        std::cout << std::endl;
+        print_sample(*ss, 0);
+    }
+    if (snapshots) snapshots->push(0, 0, ss->get_field());
+    unsigned long steps = 0;
+    unsigned long n_intervals = 0;
+    bool done = false;
+    while (!done && steps < n_steps) {
+        unsigned long chunk = n_steps - steps;
+        if (interval > 0 && interval < chunk) chunk = interval;
+        if (kmc) {
+            unsigned long s = ss->run_kmc(chunk);
+            done = s < chunk;
+            chunk = s;
+        }
+        else if (n_threads > 1)
+            // There are at most n_sites tiles; the seeds of the
+            // intervals do not overlap.
+            ss->run_tiled((double) chunk / n_sites, n_threads,
+                          seed + n_intervals * n_sites, window, tile);
+        else
+            ss->run(chunk);
+        steps += chunk;
+        n_intervals++;
+        if (interval > 0) print_sample(*ss, steps);
+        if (snapshots)
+            snapshots->push(steps, (double) steps / n_sites, ss->get_field());
+    }
+    delete snapshots;
+    if (kmc) {
+        std::cout << "Steps: " << steps;
+        if (done) std::cout << " (consensus)";
+        std::cout << std::endl;
+    }
 
-    gsl_rng_free (r);
+    if (!quiet && (!lat || lat->get_dim() == 2)) ss->print(std::cout);
+    for (unsigned int k = 1; k < n_colors; k++)
+        std::cout << "Fraction of color " << k << ": "
+                  << (double) ss->count(k) / n_sites << std::endl;
 
+    delete ss;
+    delete lat;
     return 0;
 }
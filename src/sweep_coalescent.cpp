@@ -0,0 +1,99 @@
+/**
+ * @file   sweep_coalescent.cpp
+ * @author Dominik Schrempf <dominik.schrempf@gmail.com>
+ * @date   Sun Oct 18 18:46:02 2026
+ *
+ * @brief  Diversity profile around a selective sweep.
+ *
+ * A sample is taken at the end of a sweep and its genealogies at
+ * linked neutral positions are simulated with the structured
+ * coalescent (see sweep_coalescent.h).  The positions are evenly
+ * spaced in r/s.  For each position, the mean pairwise coalescence
+ * time and the total branch length are reported relative to their
+ * neutral expectations 2N and \f$ 4N \sum_{i=1}^{n-1} 1/i \f$; these
+ * are the expected reductions of the heterozygosity and of the number
+ * of segregating sites.  The first column can be compared to the
+ * output of hitchhiking.
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <unistd.h>
+#include "sweep_coalescent.h"
+
+int main(int argc, char *argv[])
+{
+    unsigned int n = 10;        /**< Sample size. */
+    double N = 500;             /**< Diploid population size. */
+    double s = 0.1;             /**< Selection coefficient. */
+    unsigned int m = 100;       /**< Number of positions. */
+    double rs_max = 0.5;        /**< Largest r/s. */
+    unsigned long n_reps = 1000; /**< Number of replicates. */
+    unsigned int n_threads = 1; /**< Number of threads. */
+    unsigned long seed = 0;     /**< Seed. */
+    int c;
+
+    while ((c = getopt (argc, argv, "n:N:S:m:x:r:t:s:")) != -1)
+        switch (c)
+            {
+            case 'n':
+                n = atoi(optarg);
+                break;
+            case 'N':
+                N = atof(optarg);
+                break;
+            case 'S':
+                s = atof(optarg);
+                break;
+            case 'm':
+                m = atoi(optarg);
+                break;
+            case 'x':
+                rs_max = atof(optarg);
+                break;
+            case 'r':
+                n_reps = atol(optarg);
+                break;
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 's':
+                seed = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-n sample size] [-N population size]"
+                          << " [-S selection coefficient] [-m positions]"
+                          << " [-x largest r/s] [-r replicates]"
+                          << " [-t threads] [-s seed]" << std::endl;
+                return 1;
+            }
+
+    std::vector<double> r(m);
+    for (unsigned int j = 0; j < m; j++)
+        r[j] = s * rs_max * (j + 1) / m;
+
+    SweepCoalescent sc(n, N, s, r);
+    std::cout << "# Selective sweep; N " << N << ", s " << s
+              << ", duration " << sc.get_sweep_time() << " generations; "
+              << n_reps << " samples of size " << n << "." << std::endl;
+    std::cout << "# r/s, pi/pi_0, S/S_0" << std::endl;
+
+    SweepCoalescentStats stats(m);
+    sweep_coalescent_replicates(n, N, s, r, n_reps, n_threads, seed, stats);
+
+    double a = 0;
+    for (unsigned int i = 1; i < n; i++) a += 1.0 / i;
+    for (unsigned int j = 0; j < m; j++) {
+        std::cout << std::setw(10) << r[j] / s;
+        std::cout << std::setw(14)
+                  << stats.sum_pairwise_time[j] / stats.n_reps / (2.0 * N);
+        std::cout << std::setw(14)
+                  << stats.sum_length[j] / stats.n_reps / (4.0 * N * a);
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
@@ -5,6 +5,7 @@
 #include <boost/math/special_functions/binomial.hpp>
 
 #include <iostream>
+#include <cstdlib>
 #include <cmath>
 #include <string>
 #include <map>
@@ -13,6 +14,8 @@
 #include <linux/random.h>
 
 #include "ctmc.h"
+#include "gen_cache.h"
+#include "wf_forward.h"
 #include "tools.h"
 #include "getopt.h"
 
@@ -249,7 +252,73 @@ double trans_rate(gsl_matrix * q, wfstate wfsa, wfstate wfsb,
     return gsl_matrix_get(q, i, j);
 }
 
-int main()
+// Run replicate populations forward in time and print the
+// stationary distribution along the edges of the simplex, i.e., of
+// the states with at most two alleles.
+void run_forward(gsl_matrix * u, size_t K, size_t N,
+                 size_t n_reps, unsigned long n_burn,
+                 unsigned long n_gen, bool seed)
+{
+    WFForward pop(u, K, N, n_reps);
+    if (seed) {
+        unsigned long int s;
+        syscall(SYS_getrandom, &s, sizeof(unsigned long int), 0);
+        std::cout << "Seed is: " << s << "." << std::endl;
+        pop.rg->set_seed(s);
+    }
+    // Start with equal allele frequencies.
+    unsigned int n[K];
+    for (unsigned int i = 0; i < K; i++) n[i] = N / K;
+    n[0] += N - K * (N / K);
+    pop.set_state(n);
+    std::cout << "Burn in." << std::endl;
+    pop.evolve(n_burn);
+
+    // Time spent in monomorphic states and on the edges (a,b), a<b,
+    // indexed by the count of allele a.
+    std::vector<double> mono(K, 0);
+    std::vector<double> edge(K * K * (N+1), 0);
+    std::cout << "Run forward simulation." << std::endl;
+    for (unsigned long g = 0; g < n_gen; g++) {
+        pop.evolve();
+        for (size_t r = 0; r < n_reps; r++) {
+            size_t a = K;
+            size_t b = K;
+            unsigned int n_poly = 0;
+            for (size_t k = 0; k < K; k++) {
+                if (pop.get_count(r, k) == 0) continue;
+                n_poly++;
+                if (a == K) a = k;
+                else b = k;
+            }
+            if (n_poly == 1) mono[a]++;
+            else if (n_poly == 2)
+                edge[(a*K + b)*(N+1) + pop.get_count(r, a)]++;
+        }
+    }
+
+    double total = (double) n_gen * n_reps;
+    for (size_t a = 0; a < K; a++) {
+        for (size_t b = a+1; b < K; b++) {
+            std::cout << "A" << a+1 << "-A" << b+1 << " edge." << std::endl;
+            for (unsigned int i = 0; i <= N; i++) {
+                wfstate wfs(K, 0);
+                wfs[a] = i;
+                wfs[b] = N-i;
+                double f;
+                if (i == 0) f = mono[b];
+                else if (i == N) f = mono[a];
+                else f = edge[(a*K + b)*(N+1) + i];
+                p_wfs (wfs, K);
+                std::cout << " ";
+                std::cout << std::log10(N * f / total);
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
 {
     //////////////////////////////
     /// The number of alleles.  Only works for K=3 at the moment.
@@ -267,6 +336,60 @@ int main()
     int log_l = 1;
     /// Set to true for random seed.
     bool seed = false;
+    /// Directory of the cache of assembled transition rate matrices
+    /// (-c); NULL disables the cache.
+    const char * cache_dir = NULL;
+    /// Set to true (-f) to simulate generations forward in time
+    /// instead of building and running the CTMC.  Memory is then
+    /// O(K*n_reps).
+    bool forward = false;
+    /// Number of replicate populations of the forward simulation (-r).
+    size_t n_reps = 1000;
+    /// Number of burn in (-b) and sampled (-g) generations of the
+    /// forward simulation.
+    unsigned long n_burn = 1e4;
+    unsigned long n_gen = 1e5;
+
+    int c;
+    while ((c = getopt (argc, argv, "c:fr:b:g:")) != -1)
+        switch (c)
+            {
+            case 'c':
+                cache_dir = optarg;
+                break;
+            case 'f':
+                forward = true;
+                break;
+            case 'r':
+                n_reps = atol(optarg);
+                break;
+            case 'b':
+                n_burn = atol(optarg);
+                break;
+            case 'g':
+                n_gen = atol(optarg);
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-c cache directory]"
+                          << " [-f] [-r replicates] [-b burn in]"
+                          << " [-g generations]" << std::endl;
+                return 1;
+            }
+    if (forward && (n_reps < 1 || n_gen < 1)) {
+        std::cerr << "At least one replicate and one generation are needed."
+                  << std::endl;
+        return 1;
+    }
+
+    //////////////////////////////
+    if (forward) {
+        gsl_matrix * u = NULL;
+        if (K == 4) u = params_to_mut_matrix_four(m, pi, phih, N);
+        else out_error("Only four alleles supported.");
+        run_forward(u, K, N, n_reps, n_burn, n_gen, seed);
+        gsl_matrix_free(u);
+        return 0;
+    }
 
     //////////////////////////////
     // The total number of states.
@@ -289,12 +412,31 @@ int main()
         u = params_to_mut_matrix_four(m, pi, phih, N);
     else out_error("Only three and four alleles supported.");
 
-    print_flux_param_matrix(pi, phih, N);
-    exit(1);
-    
-    std::cout << "Compute transition rate matrix." << std::endl;
-    gsl_matrix * q =
-        general_wright_fisher_mut_matrix(fs_to_wfs, u, K, N, S);
+    // Look up the transition rate matrix in the cache.  The key
+    // covers all parameters that enter the matrix.
+    GenCache * cache = NULL;
+    uint64_t key = 0;
+    gsl_matrix * q = NULL;
+    if (cache_dir != NULL) {
+        std::vector<double> params;
+        params.push_back(K);
+        params.push_back(N);
+        params.insert(params.end(), m, m + 6);
+        params.insert(params.end(), pi, pi + 4);
+        params.insert(params.end(), phih, phih + 3);
+        cache = new GenCache(cache_dir);
+        key = GenCache::key("wright_fisher", &params[0], params.size());
+        q = cache->load(key);
+        if (q != NULL)
+            std::cout << "Transition rate matrix loaded from cache."
+                      << std::endl;
+    }
+    bool q_cached = (q != NULL);
+    if (!q_cached) {
+        std::cout << "Compute transition rate matrix." << std::endl;
+        q = general_wright_fisher_mut_matrix(fs_to_wfs, u, K, N, S);
+        if (cache != NULL) cache->store(key, q);
+    }
     CTMC chain(q, S);
     chain.set_log_level(log_l);
     // chain.print_info(std::cout);
@@ -404,6 +546,8 @@ int main()
     }
 
     gsl_matrix_free(u);
-    gsl_matrix_free(q);
+    if (q_cached) cache->release(q);
+    else gsl_matrix_free(q);
+    delete cache;
     return 0;
 }
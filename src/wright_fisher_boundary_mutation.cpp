@@ -11,7 +11,23 @@
 
 template double * new_zeroes<double>(unsigned int);
 
-
+// Set the mutations from the boundaries; only the rows 0 and n
+// depend on the mutation rate.
+void wright_fisher_mut_set_mu (gsl_matrix * m, size_t n, double mu) {
+    unsigned int j;
+    double smu = mu / (double) n;
+    for (j = 0; j <= n; j++) {
+        gsl_matrix_set(m, 0, j, gsl_ran_binomial_pdf (j, smu, n));
+        gsl_matrix_set(m, n, j, gsl_ran_binomial_pdf (j, (1-smu), n));
+    }
+    // Set the diagonal elements of the boundary rows.
+    double row_sum_0 = 0;
+    double row_sum_n = 0;
+    for (j = 1; j <= n; j++) row_sum_0 += gsl_matrix_get(m,0,j);
+    for (j = 0; j < n; j++) row_sum_n += gsl_matrix_get(m,n,j);
+    gsl_matrix_set(m,0,0,-row_sum_0);
+    gsl_matrix_set(m,n,n,-row_sum_n);
+}
 
 gsl_matrix * wright_fisher_mut_matrix (size_t n, double mu) {
     gsl_matrix * m = gsl_matrix_alloc(n+1, n+1);
@@ -32,11 +48,7 @@ gsl_matrix * wright_fisher_mut_matrix (size_t n, double mu) {
         }
     }
     // Set the mutations from the boundaries.
-    for (j = 0; j <= n; j++) {
-        double smu = mu / (double) n;
-        gsl_matrix_set(m, 0, j, gsl_ran_binomial_pdf (j, smu, n));
-        gsl_matrix_set(m, n, j, gsl_ran_binomial_pdf (j, (1-smu), n));
-    }
+    wright_fisher_mut_set_mu(m, n, mu);
 
     // //////////////////////////////
     // // General mutations.
@@ -52,9 +64,9 @@ gsl_matrix * wright_fisher_mut_matrix (size_t n, double mu) {
     // }
 
     //////////////////////////////
-    // Set the diagonal elements.
+    // Set the diagonal elements of the inner rows.
     double row_sum;
-    for (i = 0; i <= n; i++) {
+    for (i = 1; i < n; i++) {
         row_sum = 0;
         for (j = 0; j <= n; j++) {
             if (i != j) {
@@ -73,6 +85,8 @@ int main(int argc, char *argv[])
     unsigned int ne = 10;
     int tm = 1e6;
     double mu = 1e-2;
+    double mu_max = 1e-2;
+    unsigned int n_mu = 1;
     int log_l = 1;
     char * out_fn = NULL;
     bool seed = false;
@@ -80,7 +94,7 @@ int main(int argc, char *argv[])
 
     opterr = 0;
 
-    while ((c = getopt (argc, argv, "n:t:m:f:l:s")) != -1)
+    while ((c = getopt (argc, argv, "n:t:m:M:k:f:l:s")) != -1)
         switch (c)
             {
             case 'n':
@@ -95,6 +109,14 @@ int main(int argc, char *argv[])
                 // Mutation rate.
                 mu = atof(optarg);
                 break;
+            case 'M':
+                // Largest mutation rate of a sweep.
+                mu_max = atof(optarg);
+                break;
+            case 'k':
+                // Number of mutation rates of a sweep.
+                n_mu = atoi(optarg);
+                break;
             case 'f':
                 // Print output to file.
                 out_fn = optarg;
@@ -108,7 +130,8 @@ int main(int argc, char *argv[])
                 seed = true;
                 break;
             case '?':
-                if (optopt == 'n' || optopt == 't' || optopt == 'm') {
+                if (optopt == 'n' || optopt == 't' || optopt == 'm' ||
+                    optopt == 'M' || optopt == 'k') {
                     std::cerr << "Option -" << optopt;
                     std::cerr << " requires an argument." << std::endl;
                 }
@@ -151,14 +174,31 @@ int main(int argc, char *argv[])
     chain.set_log_level(log_l);
     // chain.print_info(std::cout);
 
-    std::cout << "Run chain." << std::endl;
-    chain.run(tm);
+    // Sweep over the mutation rates.  The matrix is assembled once;
+    // for each new mutation rate only the boundary rows are patched
+    // and the chain continues from its previous state.
+    std::vector<state> boundary_rows;
+    boundary_rows.push_back(0);
+    boundary_rows.push_back(ne);
+    for (unsigned int i = 0; i < n_mu; i++) {
+        double mu_i = mu;
+        if (n_mu > 1) mu_i += (mu_max - mu) * i / (n_mu - 1);
+        if (i > 0) {
+            wright_fisher_mut_set_mu(m, ne, mu_i);
+            chain.update_rows(boundary_rows);
+            chain.reset_analysis();
+        }
+        log_out << "Mutation rate: " << mu_i << std::endl;
+
+        std::cout << "Run chain." << std::endl;
+        chain.run(tm);
 
-    std::cout << "Print output." << std::endl;
-    // chain.print_direct_hitting_times(std::cout);
-    chain.print_hitting_times(log_out);
-    // chain.print_direct_number_jumps(std::cout);
-    chain.print_invariant_distribution(log_out);
+        std::cout << "Print output." << std::endl;
+        // chain.print_direct_hitting_times(std::cout);
+        // chain.print_hitting_times(log_out);
+        // chain.print_direct_number_jumps(std::cout);
+        chain.print_invariant_distribution(log_out);
+    }
 
     gsl_matrix_free(m);
     log_out.close();